@@ -0,0 +1,121 @@
+#include "annotation_filter.h"
+#include "char_class.h"
+#include <algorithm>
+
+namespace {
+  const uint32_t kNoState = UINT32_MAX;
+}
+
+//--------------------------------------------------------------------------------------------------
+AnnotationFilter::AnnotationFilter() :
+  compiled_(false),
+  columnCount_(0)
+{
+  std::fill(columns_, columns_ + 256, static_cast<uint16_t>(0));
+}
+
+//--------------------------------------------------------------------------------------------------
+void AnnotationFilter::Add(const std::string& name)
+{
+  if (name.empty() || std::find(names_.begin(), names_.end(), name) != names_.end())
+    return;
+
+  names_.push_back(name);
+  compiled_ = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+void AnnotationFilter::Compile()
+{
+  // Give every character that occurs in a name its own column, all other characters share column 0
+  std::fill(columns_, columns_ + 256, static_cast<uint16_t>(0));
+  columnCount_ = 1;
+  for (auto& name : names_)
+    for (char c : name)
+      if (columns_[static_cast<unsigned char>(c)] == 0)
+        columns_[static_cast<unsigned char>(c)] = static_cast<uint16_t>(columnCount_++);
+
+  // Build the trie of all names
+  transitions_.assign(columnCount_, kNoState);
+  matchLength_.assign(1, 0);
+  for (auto& name : names_)
+  {
+    uint32_t state = 0;
+    for (char c : name)
+    {
+      std::size_t edge = state * columnCount_ + columns_[static_cast<unsigned char>(c)];
+      if (transitions_[edge] == kNoState)
+      {
+        transitions_[edge] = static_cast<uint32_t>(matchLength_.size());
+        matchLength_.push_back(0);
+        transitions_.resize(transitions_.size() + columnCount_, kNoState);
+      }
+      state = transitions_[edge];
+    }
+    matchLength_[state] = static_cast<uint32_t>(name.size());
+  }
+
+  // Turn the trie into a DFA breadth first: a missing edge continues from the state of the longest
+  // proper suffix that is also in the trie, which was already completed because it is shallower.
+  std::vector<uint32_t> failure(matchLength_.size(), 0);
+  std::vector<uint32_t> queue;
+  queue.reserve(matchLength_.size());
+  matchLink_.assign(matchLength_.size(), 0);
+  for (std::size_t column = 0; column < columnCount_; ++column)
+  {
+    if (transitions_[column] == kNoState)
+      transitions_[column] = 0;
+    else
+      queue.push_back(transitions_[column]);
+  }
+
+  for (std::size_t i = 0; i < queue.size(); ++i)
+  {
+    const uint32_t state = queue[i];
+    const uint32_t fail = failure[state];
+    matchLink_[state] = matchLength_[fail] != 0 ? fail : matchLink_[fail];
+
+    for (std::size_t column = 0; column < columnCount_; ++column)
+    {
+      uint32_t& next = transitions_[state * columnCount_ + column];
+      const uint32_t failNext = transitions_[fail * columnCount_ + column];
+      if (next == kNoState)
+        next = failNext;
+      else
+      {
+        failure[next] = failNext;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  compiled_ = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void AnnotationFilter::FindAll(const char* input, std::size_t length, std::vector<std::size_t>& positions)
+{
+  if (names_.empty())
+    return;
+
+  if (!compiled_)
+    Compile();
+
+  uint32_t state = 0;
+  for (std::size_t i = 0; i < length; ++i)
+  {
+    state = transitions_[state * columnCount_ + columns_[static_cast<unsigned char>(input[i])]];
+
+    // Report the name that forms a complete identifier, if any
+    for (uint32_t match = matchLength_[state] != 0 ? state : matchLink_[state]; match != 0; match = matchLink_[match])
+    {
+      const std::size_t start = i + 1 - matchLength_[match];
+      if ((start == 0 || !HasCharClass(input[start - 1], kCharIdentifier)) &&
+          (i + 1 == length || !HasCharClass(input[i + 1], kCharIdentifier)))
+      {
+        positions.push_back(start);
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Finds the annotation macros in an input text without tokenizing it.
+ * @details The macro names are compiled into a single automaton (Aho-Corasick) over a compressed
+ * alphabet, so the input is scanned once no matter how many macro names there are. Only occurrences
+ * that form a complete identifier are reported. Occurrences in comments or strings are reported as
+ * well, the parser simply does some work for nothing in that case.
+ */
+class AnnotationFilter
+{
+public:
+  AnnotationFilter();
+
+  /// Adds a macro name to search for. Empty names are ignored.
+  void Add(const std::string& name);
+
+  /// Appends the positions of all macro names in the input to positions, in ascending order.
+  void FindAll(const char* input, std::size_t length, std::vector<std::size_t>& positions);
+
+private:
+  /// Builds the automaton from the added names
+  void Compile();
+
+private:
+  std::vector<std::string> names_;
+  bool compiled_;
+
+  /// Maps every character to a column of the transition table, 0 for characters not in any name
+  uint16_t columns_[256];
+  std::size_t columnCount_;
+
+  /// Transition table, indexed by state * columnCount_ + column
+  std::vector<uint32_t> transitions_;
+
+  /// Length of the name that ends in a state or 0, and the next state on the failure path that ends
+  /// a name
+  std::vector<uint32_t> matchLength_;
+  std::vector<uint32_t> matchLink_;
+};
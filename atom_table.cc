@@ -0,0 +1,159 @@
+#include "atom_table.h"
+#include <cstring>
+
+namespace {
+  const char* const PredefinedAtomNames[] = {
+    "",
+    "true",
+    "false",
+    "const",
+    "volatile",
+    "mutable",
+    "static",
+    "virtual",
+    "inline",
+    "constexpr",
+    "class",
+    "struct",
+    "typename",
+    "template",
+    "enum",
+    "namespace",
+    "public",
+    "protected",
+    "private",
+    "define",
+    "include",
+    "default",
+  };
+
+  static_assert(sizeof(PredefinedAtomNames) / sizeof(PredefinedAtomNames[0]) == kPredefinedAtomCount,
+    "Every predefined atom requires a name");
+
+  const std::size_t kChunkSize = 16 * 1024;
+  const std::size_t kInitialSlotCount = 256;
+
+  //------------------------------------------------------------------------------------------------
+  inline uint32_t Hash(const char* text, std::size_t length)
+  {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; ++i)
+      hash = (hash ^ static_cast<unsigned char>(text[i])) * 16777619u;
+    return hash;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+AtomTable::AtomTable() :
+  chunkCursor_(nullptr),
+  chunkRemaining_(0)
+{
+  slots_.resize(kInitialSlotCount, kAtomNone);
+
+  // The none atom is never found by a lookup
+  names_.emplace_back();
+  hashes_.push_back(0);
+
+  for (std::size_t i = 1; i < kPredefinedAtomCount; ++i)
+    Intern(PredefinedAtomNames[i], std::strlen(PredefinedAtomNames[i]));
+}
+
+//--------------------------------------------------------------------------------------------------
+Atom AtomTable::Intern(const char* text, std::size_t length)
+{
+  const uint32_t hash = Hash(text, length);
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask)
+  {
+    Atom atom = slots_[slot];
+    if (atom == kAtomNone)
+    {
+      atom = static_cast<Atom>(names_.size());
+      names_.emplace_back(Store(text, length), length);
+      hashes_.push_back(hash);
+      slots_[slot] = atom;
+
+      // Keep the load factor below one half
+      if (names_.size() * 2 > slots_.size())
+        Rehash(slots_.size() * 2);
+      return atom;
+    }
+
+    if (hashes_[atom] == hash && names_[atom].length == length &&
+        std::memcmp(names_[atom].data, text, length) == 0)
+      return atom;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void AtomTable::Truncate(std::size_t count)
+{
+  // The predefined atoms are always kept
+  if (count < kPredefinedAtomCount)
+    count = kPredefinedAtomCount;
+  if (count >= names_.size())
+    return;
+
+  names_.resize(count);
+  hashes_.resize(count);
+  names_.shrink_to_fit();
+  hashes_.shrink_to_fit();
+
+  // Names are stored in the order of their atoms. Keep the chunk that holds the last kept name and the
+  // chunks before it, and store new names right after that name.
+  const StringView& last = names_.back();
+  std::size_t keep = 0;
+  chunkCursor_ = nullptr;
+  chunkRemaining_ = 0;
+  if (last.data != nullptr)
+  {
+    while (last.data < chunks_[keep].text.get() || last.data > chunks_[keep].text.get() + chunks_[keep].size)
+      ++keep;
+
+    Chunk& chunk = chunks_[keep++];
+    const std::size_t end = static_cast<std::size_t>(last.data - chunk.text.get()) + last.length;
+    chunkCursor_ = chunk.text.get() + end;
+    chunkRemaining_ = chunk.size - end;
+  }
+  chunks_.resize(keep);
+
+  std::size_t slotCount = kInitialSlotCount;
+  while (count * 2 > slotCount)
+    slotCount *= 2;
+  Rehash(slotCount);
+  slots_.shrink_to_fit();
+}
+
+//--------------------------------------------------------------------------------------------------
+void AtomTable::Rehash(std::size_t slotCount)
+{
+  slots_.assign(slotCount, kAtomNone);
+  const std::size_t mask = slots_.size() - 1;
+  for (Atom atom = 1; atom < names_.size(); ++atom)
+  {
+    std::size_t slot = hashes_[atom] & mask;
+    while (slots_[slot] != kAtomNone)
+      slot = (slot + 1) & mask;
+    slots_[slot] = atom;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* AtomTable::Store(const char* text, std::size_t length)
+{
+  if (length > chunkRemaining_)
+  {
+    std::size_t size = length > kChunkSize ? length : kChunkSize;
+    chunks_.push_back(Chunk{ std::unique_ptr<char[]>(new char[size]), size });
+    chunkCursor_ = chunks_.back().text.get();
+    chunkRemaining_ = size;
+  }
+
+  char* result = chunkCursor_;
+  if (length > 0)
+    std::memcpy(result, text, length);
+  chunkCursor_ += length;
+  chunkRemaining_ -= length;
+  return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "token.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Atoms of the identifiers the tokenizer and parser look for. These are interned in this order by
+/// every AtomTable so they can be compared against without a lookup.
+enum : Atom
+{
+  kAtomNone = 0,
+  kAtomTrue,
+  kAtomFalse,
+  kAtomConst,
+  kAtomVolatile,
+  kAtomMutable,
+  kAtomStatic,
+  kAtomVirtual,
+  kAtomInline,
+  kAtomConstexpr,
+  kAtomClass,
+  kAtomStruct,
+  kAtomTypename,
+  kAtomTemplate,
+  kAtomEnum,
+  kAtomNamespace,
+  kAtomPublic,
+  kAtomProtected,
+  kAtomPrivate,
+  kAtomDefine,
+  kAtomInclude,
+  kAtomDefault,
+
+  kPredefinedAtomCount
+};
+
+/// Maps every distinct identifier to a small integer
+class AtomTable
+{
+public:
+  AtomTable();
+
+  // Do not allow copy or move
+  AtomTable(const AtomTable& other) = delete;
+  AtomTable(AtomTable&& other) = delete;
+
+  /// Returns the atom of the given text, adding it to the table if it is not already present
+  Atom Intern(const char* text, std::size_t length);
+  Atom Intern(const std::string& text) { return Intern(text.data(), text.size()); }
+
+  /// Returns the text of the given atom. The text remains valid until the atom is removed by Truncate.
+  const StringView& Name(Atom atom) const { return names_[atom]; }
+
+  /// Returns the number of atoms, including kAtomNone
+  std::size_t size() const { return names_.size(); }
+
+  /// Removes the atoms that were interned after the table held the given number of atoms and frees
+  /// their names. The predefined atoms are always kept, and the atoms that are kept and their names do
+  /// not change.
+  void Truncate(std::size_t count);
+
+private:
+  /// Rebuilds the hash slots with the given number of slots, a power of two
+  void Rehash(std::size_t slotCount);
+
+  /// Copies the text into the name storage
+  const char* Store(const char* text, std::size_t length);
+
+private:
+  /// Text and hash of every atom, indexed by atom
+  std::vector<StringView> names_;
+  std::vector<uint32_t> hashes_;
+
+  /// Open addressing hash table of atoms, kAtomNone marks an empty slot
+  std::vector<Atom> slots_;
+
+  /// Storage of the atom names
+  struct Chunk
+  {
+    std::unique_ptr<char[]> text;
+    std::size_t size;
+  };
+  std::vector<Chunk> chunks_;
+  char* chunkCursor_;
+  std::size_t chunkRemaining_;
+};
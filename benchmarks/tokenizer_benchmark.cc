@@ -0,0 +1,114 @@
+#include "token.h"
+#include "tokenizer.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace {
+  typedef std::chrono::steady_clock Clock;
+
+  /// Every input is lexed this many times, the fastest run is reported
+  const int kRuns = 5;
+
+  /// A run lexes an input repeatedly until it took at least this long
+  const std::chrono::milliseconds kMinimumRunTime(200);
+
+  /// Size of the synthetic input in bytes
+  const std::size_t kSyntheticSize = 16 * 1024 * 1024;
+
+  /// Returns a header of about the given size that mixes the tokens of typical annotated headers
+  std::string synthetic_input(std::size_t size)
+  {
+    std::string input = "#pragma once\n#include <vector>\n#include \"local.h\"\n\n";
+    for (std::size_t i = 0; input.size() < size; ++i)
+    {
+      const std::string n = std::to_string(i);
+      input +=
+        "namespace module" + n + "\n{\n"
+        "  /// Documentation of class " + n + "\n"
+        "  TCLASS(Name=\"Class" + n + "\", Version=" + n + ", Ratio=0.25)\n"
+        "  template<typename T, typename Allocator = std::allocator<T>>\n"
+        "  class Class" + n + " : public Base<T>, protected Other\n"
+        "  {\n"
+        "  public:\n"
+        "    TCONSTRUCTOR()\n"
+        "    Class" + n + "(const T& value = T(), int count = 0x" + n + ") : value_(value), count_(count) {}\n\n"
+        "    TFUNC(Category=\"Math\")\n"
+        "    virtual std::vector<T>& Compute(const std::vector<T>* input, float scale = 1.5f) const = 0;\n\n"
+        "    /* A function that is not annotated */\n"
+        "    inline bool Check(unsigned long mask) const { return (count_ & mask) != 0 && count_ >= 10 || count_ <<= 2; }\n\n"
+        "    TENUM()\n"
+        "    enum class Mode : uint8_t { kFirst, kSecond = 2, kThird = kSecond | 1 };\n\n"
+        "  private:\n"
+        "    TPROPERTY()\n"
+        "    T value_;\n"
+        "    TPROPERTY(Transient)\n"
+        "    int count_[" + n + "];\n"
+        "    const char* name_ = \"name\\t" + n + "\";\n"
+        "    char separator_ = ',';\n"
+        "  };\n"
+        "}\n\n";
+    }
+    return input;
+  }
+
+  /// Returns the number of tokens in the input
+  std::size_t count_tokens(Tokenizer& tokenizer, const std::string& input)
+  {
+    tokenizer.Reset(input.data(), input.size());
+    Token token;
+    std::size_t count = 0;
+    while (tokenizer.GetToken(token))
+      ++count;
+    return count;
+  }
+
+  /// Lexes the input and prints the number of tokens per second of the fastest run
+  void benchmark(const std::string& name, const std::string& input)
+  {
+    Tokenizer tokenizer;
+    double bestSeconds = 0.0;
+    std::size_t tokens = 0;
+    for (int run = 0; run < kRuns; ++run)
+    {
+      std::size_t repetitions = 0;
+      const Clock::time_point start = Clock::now();
+      Clock::duration elapsed;
+      do
+      {
+        tokens = count_tokens(tokenizer, input);
+        ++repetitions;
+        elapsed = Clock::now() - start;
+      } while (elapsed < kMinimumRunTime);
+
+      const double seconds = std::chrono::duration<double>(elapsed).count() / repetitions;
+      if (run == 0 || seconds < bestSeconds)
+        bestSeconds = seconds;
+    }
+
+    std::printf("%-32s %10zu bytes %10zu tokens %10.2f Mtokens/s %8.1f MiB/s\n", name.c_str(), input.size(),
+      tokens, tokens / bestSeconds / 1e6, input.size() / bestSeconds / (1024.0 * 1024.0));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+/// Lexes the files given on the command line and a synthetic header and prints the tokens per second
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::ifstream file(argv[i], std::ios::binary);
+    if (!file)
+    {
+      std::cout << "Unable to open " << argv[i] << std::endl;
+      return 1;
+    }
+    benchmark(argv[i], std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+  }
+
+  benchmark("synthetic", synthetic_input(kSyntheticSize));
+  return 0;
+}
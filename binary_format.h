@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Layout of the binary output format.
+ * @details A binary file is a sequence of little endian 32 bit words:
+ *
+ *   header        kBinaryHeaderWords words: magic, version and two reserved words
+ *   declarations  one record per declaration, in the order of the input
+ *   types         kBinaryTypeWords words per distinct type node, indexed by type id
+ *   arguments     kBinaryTypeArgumentWords words per argument of a template or function type
+ *   index         kBinaryIndexWords words per declaration
+ *   strings       the text of all strings, padded to a multiple of 4 bytes
+ *   trailer       kBinaryTrailerWords words, see BinaryTrailer
+ *
+ * Offsets are in bytes from the start of the file. Strings are stored as two words, the offset of the
+ * text relative to the strings section and its length in bytes. Types are referred to by their id;
+ * equal types share an id, as in the types table of the json output.
+ *
+ * Every declaration record starts with the kBinaryRecordWords words of BinaryRecord, followed by the
+ * meta entries of the annotation and then by the arrays of the kind of declaration:
+ *
+ *   kClass        template arguments (extra[0] of them), then parents (extra[1] of them)
+ *   kEnum         enumerators (extra[2] of them), extra[0..1] is the underlying type
+ *   kProperty     extra[0] is the data type, extra[1..2] the number of elements of an array
+ *   kFunction     arguments (extra[3] of them), extra[0..1] is the macro, extra[2] the return type
+ *   kConstructor  arguments (extra[0] of them)
+ *
+ * The index entry of a declaration holds the offset of its record, the index of the declaration it is
+ * a member of and the index one past its last member, so the members of a scope can be walked without
+ * reading the records in between.
+ */
+
+/// "HPB1" in the first and the last word of a file
+static const uint32_t kBinaryMagic = 0x31425048u;
+static const uint32_t kBinaryVersion = 1;
+
+/// Index of the parent of top level declarations
+static const uint32_t kBinaryNoParent = UINT32_MAX;
+
+/// Marks a type field that does not refer to a type
+static const uint32_t kBinaryNoType = UINT32_MAX;
+
+enum class BinaryKind : uint8_t
+{
+  kInclude,
+  kNamespace,
+  kClass,
+  kEnum,
+  kProperty,
+  kFunction,
+  kConstructor,
+  kMacro
+};
+
+/// Access of members of classes, kNone for all other declarations
+enum class BinaryAccess : uint8_t
+{
+  kNone,
+  kPublic,
+  kProtected,
+  kPrivate
+};
+
+/// Bits of the flags of a record
+enum BinaryFlags : uint16_t
+{
+  // kClass
+  kBinaryStruct = 1 << 0,
+  kBinaryTemplate = 1 << 1,
+
+  // kEnum
+  kBinaryEnumClass = 1 << 0,
+
+  // kProperty
+  kBinaryArray = 1 << 0,
+
+  // kProperty, kFunction and kConstructor
+  kBinaryMutable = 1 << 1,
+  kBinaryStatic = 1 << 2,
+  kBinaryInline = 1 << 3,
+  kBinaryVirtual = 1 << 4,
+  kBinaryConstExpr = 1 << 5,
+  kBinaryConst = 1 << 6,
+  kBinaryAbstract = 1 << 7,
+  kBinaryDefault = 1 << 8
+};
+
+/// Types of values, stored in the first of the kBinaryValueWords words of a value
+enum class BinaryValueType : uint8_t
+{
+  /// No value, a meta entry without value or an argument without default value
+  kNone,
+
+  /// Text, the value is a string
+  kText,
+  kBoolean,
+  kUInt32,
+  kInt32,
+  kUInt64,
+  kInt64,
+  kReal,
+
+  /// A nested sequence of meta entries, the value is the number of entries that follow and belong to it
+  kSequence
+};
+
+enum class BinaryTypeKind : uint8_t
+{
+  kPointer,
+  kReference,
+  kLReference,
+  kLiteral,
+  kTemplate,
+  kFunction
+};
+
+/// Bits of the first word of a type node, next to the BinaryTypeKind in the low byte
+enum BinaryTypeFlags : uint32_t
+{
+  kBinaryTypeConst = 1 << 8,
+  kBinaryTypeVolatile = 1 << 9,
+  kBinaryTypeMutable = 1 << 10
+};
+
+// Sizes in words
+static const uint32_t kBinaryHeaderWords = 4;
+static const uint32_t kBinaryStringWords = 2;
+
+/// Value type, then two words of payload: a string, or the low and high word of the constant
+static const uint32_t kBinaryValueWords = 3;
+
+/// Size, kind | access << 8 | flags << 16, line, name, comment, meta count and four kind specific words
+static const uint32_t kBinaryRecordWords = 12;
+
+/// Key and value
+static const uint32_t kBinaryMetaWords = kBinaryStringWords + kBinaryValueWords;
+
+/// Type parameter key, name and default type
+static const uint32_t kBinaryTemplateArgumentWords = 2 * kBinaryStringWords + 1;
+
+/// Access and type
+static const uint32_t kBinaryParentWords = 2;
+
+/// Key, value and a word that is 1 if there is a value
+static const uint32_t kBinaryEnumeratorWords = 2 * kBinaryStringWords + 1;
+
+/// Type, name and default value
+static const uint32_t kBinaryArgumentWords = 1 + kBinaryStringWords + kBinaryValueWords;
+
+/// Kind and flags, then the base type (pointers and references), the name (literals), the name and
+/// arguments (templates) or the return type and arguments (functions). Arguments are the index of the
+/// first one and their count.
+static const uint32_t kBinaryTypeWords = 5;
+
+/// Name (empty for template arguments) and type
+static const uint32_t kBinaryTypeArgumentWords = kBinaryStringWords + 1;
+
+/// Offset of the record, parent index and end index
+static const uint32_t kBinaryIndexWords = 3;
+
+/// Declaration count, index offset, type count, types offset, type argument count, type arguments
+/// offset, strings size, strings offset, version and magic
+static const uint32_t kBinaryTrailerWords = 10;
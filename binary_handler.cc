@@ -0,0 +1,445 @@
+#include "binary_handler.h"
+#include <cstring>
+
+namespace {
+  //------------------------------------------------------------------------------------------------
+  BinaryAccess ToBinaryAccess(AccessControlType access)
+  {
+    switch (access)
+    {
+    case AccessControlType::kPublic:
+      return BinaryAccess::kPublic;
+    case AccessControlType::kProtected:
+      return BinaryAccess::kProtected;
+    case AccessControlType::kPrivate:
+      return BinaryAccess::kPrivate;
+    }
+    return BinaryAccess::kNone;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  BinaryValueType ToBinaryValueType(ConstType type)
+  {
+    switch (type)
+    {
+    case ConstType::kBoolean:
+      return BinaryValueType::kBoolean;
+    case ConstType::kUInt32:
+      return BinaryValueType::kUInt32;
+    case ConstType::kInt32:
+      return BinaryValueType::kInt32;
+    case ConstType::kUInt64:
+      return BinaryValueType::kUInt64;
+    case ConstType::kInt64:
+      return BinaryValueType::kInt64;
+    case ConstType::kReal:
+      return BinaryValueType::kReal;
+    case ConstType::kString:
+      break;
+    }
+    return BinaryValueType::kText;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+BinaryHandler::BinaryHandler(const Options&) :
+  offset_(0)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Reset()
+{
+  output_.Clear();
+  record_.clear();
+  index_.clear();
+  scopes_.clear();
+  types_.Clear();
+  strings_.clear();
+  offset_ = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::StartDocument()
+{
+  WriteWord(kBinaryMagic);
+  WriteWord(kBinaryVersion);
+  WriteWord(0);
+  WriteWord(0);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::EndDocument()
+{
+  // Scopes that are still open at the end of the input contain everything that follows them
+  while (!scopes_.empty())
+    EndScope();
+
+  // WriteTypes leaves the arguments of the types in record_
+  const uint32_t typesOffset = offset_;
+  WriteTypes();
+  const uint32_t typeArgumentsOffset = typesOffset + static_cast<uint32_t>(types_.size()) * kBinaryTypeWords * 4;
+  const uint32_t typeArgumentCount = static_cast<uint32_t>(record_.size() / kBinaryTypeArgumentWords);
+
+  const uint32_t indexOffset = offset_;
+  for (uint32_t word : index_)
+    WriteWord(word);
+
+  const uint32_t stringsOffset = offset_;
+  for (char c : strings_)
+    output_.Put(c);
+  for (std::size_t i = strings_.size(); i % 4 != 0; ++i)
+    output_.Put('\0');
+  offset_ += static_cast<uint32_t>((strings_.size() + 3) & ~std::size_t(3));
+
+  WriteWord(static_cast<uint32_t>(index_.size() / kBinaryIndexWords));
+  WriteWord(indexOffset);
+  WriteWord(static_cast<uint32_t>(types_.size()));
+  WriteWord(typesOffset);
+  WriteWord(typeArgumentCount);
+  WriteWord(typeArgumentsOffset);
+  WriteWord(static_cast<uint32_t>(strings_.size()));
+  WriteWord(stringsOffset);
+  WriteWord(kBinaryVersion);
+  WriteWord(kBinaryMagic);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Include(const IncludeInfo& info)
+{
+  StartRecord(BinaryKind::kInclude, info.file);
+  record_.resize(kBinaryRecordWords);
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::StartNamespace(const NamespaceInfo& info)
+{
+  StartRecord(BinaryKind::kNamespace, info.name);
+  record_.resize(kBinaryRecordWords);
+  EndRecord(true);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::EndNamespace()
+{
+  EndScope();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::StartClass(const ClassInfo& info)
+{
+  const uint16_t flags = static_cast<uint16_t>((info.isStruct ? kBinaryStruct : 0) | (info.isTemplate ? kBinaryTemplate : 0));
+  StartRecord(BinaryKind::kClass, info.name, info, flags);
+  record_.push_back(static_cast<uint32_t>(info.templateArguments.size()));
+  record_.push_back(static_cast<uint32_t>(info.parents.size()));
+  AddMeta(info);
+
+  for (const TemplateArgumentInfo& argument : info.templateArguments)
+  {
+    AddString(argument.typeParameterKey);
+    AddString(argument.name);
+    record_.push_back(argument.defaultType == kNoTypeNode ? kBinaryNoType : AddType(info, argument.defaultType));
+  }
+
+  for (const ParentInfo& parent : info.parents)
+  {
+    record_.push_back(static_cast<uint32_t>(ToBinaryAccess(parent.access)));
+    record_.push_back(AddType(info, parent.type));
+  }
+
+  EndRecord(true);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::EndClass()
+{
+  EndScope();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Enum(const EnumInfo& info)
+{
+  StartRecord(BinaryKind::kEnum, info.name, info, info.isEnumClass ? kBinaryEnumClass : 0);
+  AddString(info.base);
+  record_.push_back(static_cast<uint32_t>(info.members.size()));
+  AddMeta(info);
+
+  for (const EnumeratorInfo& member : info.members)
+  {
+    AddString(member.key);
+    AddString(member.value);
+    record_.push_back(member.hasValue ? 1 : 0);
+  }
+
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Property(const PropertyInfo& info)
+{
+  const uint16_t flags = static_cast<uint16_t>((info.isArray ? kBinaryArray : 0) |
+    (info.isMutable ? kBinaryMutable : 0) | (info.isStatic ? kBinaryStatic : 0));
+  StartRecord(BinaryKind::kProperty, info.name, info, flags);
+  record_.push_back(AddType(info, info.dataType));
+  AddString(info.elements);
+  AddMeta(info);
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Function(const FunctionInfo& info)
+{
+  const uint16_t flags = static_cast<uint16_t>((info.isVirtual ? kBinaryVirtual : 0) |
+    (info.isInline ? kBinaryInline : 0) | (info.isConstExpr ? kBinaryConstExpr : 0) |
+    (info.isStatic ? kBinaryStatic : 0) | (info.isConst ? kBinaryConst : 0) |
+    (info.isAbstract ? kBinaryAbstract : 0));
+  StartRecord(BinaryKind::kFunction, info.name, info, flags);
+  AddString(info.macro);
+  record_.push_back(AddType(info, info.returnType));
+  record_.push_back(static_cast<uint32_t>(info.arguments.size()));
+  AddMeta(info);
+  AddArguments(info, info.arguments);
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Constructor(const ConstructorInfo& info)
+{
+  const uint16_t flags = static_cast<uint16_t>((info.isInline ? kBinaryInline : 0) | (info.isDefault ? kBinaryDefault : 0));
+  StartRecord(BinaryKind::kConstructor, info.name, info, flags);
+  record_.push_back(static_cast<uint32_t>(info.arguments.size()));
+  AddMeta(info);
+  AddArguments(info, info.arguments);
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::Macro(const MacroInfo& info)
+{
+  StartRecord(BinaryKind::kMacro, info.name, info, 0);
+  AddMeta(info);
+  EndRecord();
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::StartRecord(BinaryKind kind, const StringView& name)
+{
+  record_.clear();
+  record_.push_back(0);
+  record_.push_back(static_cast<uint32_t>(kind));
+  record_.push_back(0);
+  AddString(name);
+  AddString(StringView());
+  record_.push_back(0);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::StartRecord(BinaryKind kind, const StringView& name, const DeclarationInfo& info, uint16_t flags)
+{
+  record_.clear();
+  record_.push_back(0);
+  const BinaryAccess access = info.isMember ? ToBinaryAccess(info.access) : BinaryAccess::kNone;
+  record_.push_back(static_cast<uint32_t>(kind) | static_cast<uint32_t>(access) << 8 | static_cast<uint32_t>(flags) << 16);
+  record_.push_back(static_cast<uint32_t>(info.line));
+  AddString(name);
+  AddString(info.comment);
+  record_.push_back(static_cast<uint32_t>(info.metaCount));
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::AddMeta(const DeclarationInfo& info)
+{
+  // The meta entries directly follow the fixed part of the record, pad the kind specific words
+  record_.resize(kBinaryRecordWords);
+  for (std::size_t i = 0; i < info.metaCount; ++i)
+  {
+    const MetaEntry& entry = info.meta[i];
+    AddString(entry.key);
+    switch (entry.type)
+    {
+    case MetaEntry::Type::kNull:
+      record_.push_back(static_cast<uint32_t>(BinaryValueType::kNone));
+      record_.push_back(0);
+      record_.push_back(0);
+      break;
+    case MetaEntry::Type::kValue:
+      AddValue(entry.value);
+      break;
+    case MetaEntry::Type::kSequence:
+      record_.push_back(static_cast<uint32_t>(BinaryValueType::kSequence));
+      record_.push_back(static_cast<uint32_t>(entry.count));
+      record_.push_back(0);
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::EndRecord(bool scope)
+{
+  record_[0] = static_cast<uint32_t>(record_.size());
+
+  const uint32_t declaration = static_cast<uint32_t>(index_.size() / kBinaryIndexWords);
+  index_.push_back(offset_);
+  index_.push_back(scopes_.empty() ? kBinaryNoParent : scopes_.back());
+  index_.push_back(declaration + 1);
+  if (scope)
+    scopes_.push_back(declaration);
+
+  for (uint32_t word : record_)
+    WriteWord(word);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::EndScope()
+{
+  // The members of the scope end with the last declaration so far
+  const uint32_t declaration = scopes_.back();
+  scopes_.pop_back();
+  index_[declaration * kBinaryIndexWords + 2] = static_cast<uint32_t>(index_.size() / kBinaryIndexWords);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::AddString(const StringView& str)
+{
+  record_.push_back(static_cast<uint32_t>(strings_.size()));
+  record_.push_back(static_cast<uint32_t>(str.length));
+  strings_.append(str.data, str.length);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::AddValue(const Token& token)
+{
+  if (token.tokenType != TokenType::kConst || token.constType == ConstType::kString)
+  {
+    record_.push_back(static_cast<uint32_t>(BinaryValueType::kText));
+    AddString(token.token);
+    return;
+  }
+
+  uint64_t bits = 0;
+  switch (token.constType)
+  {
+  case ConstType::kBoolean:
+    bits = token.boolConst ? 1 : 0;
+    break;
+  case ConstType::kUInt32:
+    bits = token.uint32Const;
+    break;
+  case ConstType::kInt32:
+    bits = static_cast<uint64_t>(static_cast<int64_t>(token.int32Const));
+    break;
+  case ConstType::kReal:
+    std::memcpy(&bits, &token.realConst, sizeof(bits));
+    break;
+  default:
+    bits = token.uint64Const;
+    break;
+  }
+
+  record_.push_back(static_cast<uint32_t>(ToBinaryValueType(token.constType)));
+  record_.push_back(static_cast<uint32_t>(bits));
+  record_.push_back(static_cast<uint32_t>(bits >> 32));
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::AddArguments(const DeclarationInfo& info, const std::vector<ArgumentInfo>& arguments)
+{
+  for (const ArgumentInfo& argument : arguments)
+  {
+    record_.push_back(AddType(info, argument.type));
+    AddString(argument.name);
+    if (argument.hasDefaultValue)
+      AddValue(argument.defaultValue);
+    else
+    {
+      record_.push_back(static_cast<uint32_t>(BinaryValueType::kNone));
+      record_.push_back(0);
+      record_.push_back(0);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t BinaryHandler::AddType(const DeclarationInfo& info, uint32_t type)
+{
+  return types_.Intern(*info.types, type);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::WriteWord(uint32_t word)
+{
+  output_.Put(static_cast<char>(word));
+  output_.Put(static_cast<char>(word >> 8));
+  output_.Put(static_cast<char>(word >> 16));
+  output_.Put(static_cast<char>(word >> 24));
+  offset_ += 4;
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::WriteTypes()
+{
+  // The arguments are collected in record_ while the nodes are written, and written after them
+  record_.clear();
+  const TypeTree& tree = types_.types();
+  for (uint32_t id = 0; id < types_.size(); ++id)
+  {
+    const TypeNode& node = tree.node(id);
+    WriteWord(static_cast<uint32_t>(node.type) |
+      (node.isConst ? static_cast<uint32_t>(kBinaryTypeConst) : 0u) |
+      (node.isVolatile ? static_cast<uint32_t>(kBinaryTypeVolatile) : 0u) |
+      (node.isMutable ? static_cast<uint32_t>(kBinaryTypeMutable) : 0u));
+
+    uint32_t words[4] = { 0, 0, 0, 0 };
+    switch (node.type)
+    {
+    case TypeNode::Type::kPointer:
+    case TypeNode::Type::kReference:
+    case TypeNode::Type::kLReference:
+      words[0] = node.base;
+      break;
+    case TypeNode::Type::kLiteral:
+      AddTypeName(tree.text(node.named.name), words);
+      break;
+    case TypeNode::Type::kTemplate:
+      AddTypeName(tree.text(node.named.name), words);
+      words[2] = AddTypeArguments(tree, node.named.arguments);
+      words[3] = node.named.arguments.count;
+      break;
+    case TypeNode::Type::kFunction:
+      words[0] = node.function.returns;
+      words[1] = AddTypeArguments(tree, node.function.arguments);
+      words[2] = node.function.arguments.count;
+      break;
+    }
+
+    for (uint32_t word : words)
+      WriteWord(word);
+  }
+
+  for (uint32_t word : record_)
+    WriteWord(word);
+}
+
+//--------------------------------------------------------------------------------------------------
+void BinaryHandler::AddTypeName(const StringView& name, uint32_t* words)
+{
+  words[0] = static_cast<uint32_t>(strings_.size());
+  words[1] = static_cast<uint32_t>(name.length);
+  strings_.append(name.data, name.length);
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t BinaryHandler::AddTypeArguments(const TypeTree& tree, const TypeRange& arguments)
+{
+  const uint32_t first = static_cast<uint32_t>(record_.size() / kBinaryTypeArgumentWords);
+  for (uint32_t i = 0; i < arguments.count; ++i)
+  {
+    const TypeArgument& argument = tree.argument(arguments.first + i);
+    AddString(tree.text(argument.name));
+    record_.push_back(argument.type);
+  }
+  return first;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "binary_format.h"
+#include "handler.h"
+#include "options.h"
+#include "output_stream.h"
+#include "type_table.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Handler that writes the declarations in the binary format described in binary_format.h.
+ * @details The records are written as the declarations are reported. The types, the index and the
+ * strings are collected in memory and written at the end of the document. Like JsonHandler it is not
+ * derived from Handler so a parser resolves all calls at compile time.
+ */
+class BinaryHandler
+{
+public:
+  BinaryHandler(const Options& options);
+
+  // Do not allow copy or move
+  BinaryHandler(const BinaryHandler& other) = delete;
+  BinaryHandler(BinaryHandler&& other) = delete;
+
+  /// Discards the output of a previous document
+  void Reset();
+
+  /// Writes the header and everything that follows the records
+  void StartDocument();
+  void EndDocument();
+
+  /// The stream the document is written to
+  OutputStream& output() { return output_; }
+  const OutputStream& output() const { return output_; }
+
+  // See Handler
+  void Include(const IncludeInfo& info);
+  void StartNamespace(const NamespaceInfo& info);
+  void EndNamespace();
+  void StartClass(const ClassInfo& info);
+  void EndClass();
+  void Enum(const EnumInfo& info);
+  void Property(const PropertyInfo& info);
+  void Function(const FunctionInfo& info);
+  void Constructor(const ConstructorInfo& info);
+  void Macro(const MacroInfo& info);
+
+private:
+  /// Starts the record of a declaration in record_
+  void StartRecord(BinaryKind kind, const StringView& name);
+  void StartRecord(BinaryKind kind, const StringView& name, const DeclarationInfo& info, uint16_t flags);
+
+  /// Writes the record to the output and adds it to the index. Scopes stay open until EndScope.
+  void EndRecord(bool scope = false);
+  void EndScope();
+
+  /// Pads the fixed part of the record and adds the meta entries
+  void AddMeta(const DeclarationInfo& info);
+
+  void AddString(const StringView& str);
+  void AddValue(const Token& token);
+  void AddArguments(const DeclarationInfo& info, const std::vector<ArgumentInfo>& arguments);
+  uint32_t AddType(const DeclarationInfo& info, uint32_t type);
+
+  void WriteWord(uint32_t word);
+
+  /// Writes the type nodes and collects their arguments in record_
+  void WriteTypes();
+  void AddTypeName(const StringView& name, uint32_t* words);
+  uint32_t AddTypeArguments(const TypeTree& tree, const TypeRange& arguments);
+
+private:
+  /// The words of the record that is being built
+  std::vector<uint32_t> record_;
+
+  /// The index entries of all declarations and the declarations of the open scopes
+  std::vector<uint32_t> index_;
+  std::vector<uint32_t> scopes_;
+
+  TypeTable types_;
+  std::string strings_;
+
+  /// Number of bytes written so far
+  uint32_t offset_;
+
+  OutputStream output_;
+};
@@ -0,0 +1,424 @@
+#pragma once
+
+#include "binary_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Reads the files written by BinaryHandler in place. The file is mapped into memory and all accessors
+// decode the words they need on demand, so walking the declarations and types neither parses the file
+// nor allocates memory. This header only depends on binary_format.h and can be copied to other tools.
+
+class BinaryReader;
+
+/// A string in a binary file, not NUL terminated
+struct BinaryString
+{
+  const char* data;
+  uint32_t length;
+
+  std::string str() const { return std::string(data, length); }
+  bool empty() const { return length == 0; }
+  bool operator==(const char* other) const { return std::strncmp(data, other, length) == 0 && other[length] == '\0'; }
+  bool operator!=(const char* other) const { return !(*this == other); }
+};
+
+/// Base of the views of the items of a binary file
+class BinaryView
+{
+public:
+  BinaryView(const BinaryReader& reader, std::size_t offset) : reader_(&reader), offset_(offset) {}
+
+protected:
+  uint32_t Word(std::size_t index) const;
+  BinaryString String(std::size_t index) const;
+
+  const BinaryReader* reader_;
+
+  /// Offset of the item in the file in bytes
+  std::size_t offset_;
+};
+
+/// A meta value or default value
+class BinaryValue : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  BinaryValueType type() const { return static_cast<BinaryValueType>(Word(0)); }
+
+  BinaryString text() const { return String(1); }
+  bool boolean() const { return bits() != 0; }
+  uint32_t uint32() const { return Word(1); }
+  int32_t int32() const { return static_cast<int32_t>(Word(1)); }
+  uint64_t uint64() const { return bits(); }
+  int64_t int64() const { return static_cast<int64_t>(bits()); }
+  double real() const { double value; uint64_t b = bits(); std::memcpy(&value, &b, sizeof(value)); return value; }
+
+  /// Number of entries of a kSequence value
+  uint32_t count() const { return Word(1); }
+
+private:
+  uint64_t bits() const { return Word(1) | static_cast<uint64_t>(Word(2)) << 32; }
+};
+
+/// An entry of the arguments of an annotation macro, see MetaEntry
+class BinaryMetaEntry : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  BinaryString key() const { return String(0); }
+  BinaryValue value() const { return BinaryValue(*reader_, offset_ + kBinaryStringWords * 4); }
+};
+
+class BinaryTemplateArgument : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  BinaryString typeParameterKey() const { return String(0); }
+  BinaryString name() const { return String(2); }
+
+  /// Id of the default type or kBinaryNoType
+  uint32_t defaultType() const { return Word(4); }
+};
+
+class BinaryParent : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  BinaryAccess access() const { return static_cast<BinaryAccess>(Word(0)); }
+  uint32_t type() const { return Word(1); }
+};
+
+class BinaryEnumerator : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  BinaryString key() const { return String(0); }
+  bool hasValue() const { return Word(4) != 0; }
+  BinaryString value() const { return String(2); }
+};
+
+class BinaryArgument : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  uint32_t type() const { return Word(0); }
+  BinaryString name() const { return String(1); }
+
+  /// The default value, of type kNone if there is none
+  BinaryValue defaultValue() const { return BinaryValue(*reader_, offset_ + (1 + kBinaryStringWords) * 4); }
+};
+
+/// A declaration record, see binary_format.h for the fields of each kind
+class BinaryDeclaration : public BinaryView
+{
+public:
+  BinaryDeclaration(const BinaryReader& reader, uint32_t index);
+
+  /// Index of the declaration, of the declaration it is a member of, and one past its last member
+  uint32_t index() const { return index_; }
+  uint32_t parent() const;
+  uint32_t end() const;
+
+  BinaryKind kind() const { return static_cast<BinaryKind>(Word(1) & 0xff); }
+  BinaryAccess access() const { return static_cast<BinaryAccess>((Word(1) >> 8) & 0xff); }
+  bool is(BinaryFlags flag) const { return ((Word(1) >> 16) & flag) != 0; }
+  uint32_t line() const { return Word(2); }
+
+  /// The name, the file of includes and the macro name of custom macros
+  BinaryString name() const { return String(3); }
+  BinaryString comment() const { return String(5); }
+
+  uint32_t metaCount() const { return Word(7); }
+  BinaryMetaEntry meta(uint32_t i) const { return BinaryMetaEntry(*reader_, offset_ + (kBinaryRecordWords + kBinaryMetaWords * i) * 4); }
+
+  // kClass
+  uint32_t templateArgumentCount() const { return Word(8); }
+  BinaryTemplateArgument templateArgument(uint32_t i) const { return BinaryTemplateArgument(*reader_, Item(0, kBinaryTemplateArgumentWords, i)); }
+  uint32_t parentCount() const { return Word(9); }
+  BinaryParent parent(uint32_t i) const { return BinaryParent(*reader_, Item(Word(8) * kBinaryTemplateArgumentWords, kBinaryParentWords, i)); }
+
+  // kEnum
+  BinaryString base() const { return String(8); }
+  uint32_t enumeratorCount() const { return Word(10); }
+  BinaryEnumerator enumerator(uint32_t i) const { return BinaryEnumerator(*reader_, Item(0, kBinaryEnumeratorWords, i)); }
+
+  // kProperty
+  uint32_t dataType() const { return Word(8); }
+  BinaryString elements() const { return String(9); }
+
+  // kFunction
+  BinaryString macro() const { return String(8); }
+  uint32_t returnType() const { return Word(10); }
+
+  // kFunction and kConstructor
+  uint32_t argumentCount() const { return Word(kind() == BinaryKind::kFunction ? 11 : 8); }
+  BinaryArgument argument(uint32_t i) const { return BinaryArgument(*reader_, Item(0, kBinaryArgumentWords, i)); }
+
+private:
+  /// Returns the offset of the i-th item of the given size that starts the given number of words after
+  /// the meta entries
+  std::size_t Item(std::size_t skip, std::size_t size, uint32_t i) const
+  {
+    return offset_ + (kBinaryRecordWords + metaCount() * kBinaryMetaWords + skip + size * i) * 4;
+  }
+
+  uint32_t index_;
+};
+
+/// An argument of a template or function type
+class BinaryTypeArgument : public BinaryView
+{
+public:
+  using BinaryView::BinaryView;
+
+  /// The name of a function argument, empty for template arguments and unnamed function arguments
+  BinaryString name() const { return String(0); }
+  uint32_t type() const { return Word(2); }
+};
+
+/// A type node, see TypeNode
+class BinaryType : public BinaryView
+{
+public:
+  BinaryType(const BinaryReader& reader, uint32_t id);
+
+  uint32_t id() const { return id_; }
+  BinaryTypeKind kind() const { return static_cast<BinaryTypeKind>(Word(0) & 0xff); }
+  bool isConst() const { return (Word(0) & kBinaryTypeConst) != 0; }
+  bool isVolatile() const { return (Word(0) & kBinaryTypeVolatile) != 0; }
+  bool isMutable() const { return (Word(0) & kBinaryTypeMutable) != 0; }
+
+  /// The type pointers and references refer to
+  uint32_t base() const { return Word(1); }
+
+  /// The name of literals and templates
+  BinaryString name() const { return String(1); }
+
+  /// The return type of functions
+  uint32_t returnType() const { return Word(1); }
+
+  /// The arguments of templates and functions
+  uint32_t argumentCount() const { return Word(kind() == BinaryTypeKind::kFunction ? 3 : 4); }
+  BinaryTypeArgument argument(uint32_t i) const;
+
+private:
+  uint32_t id_;
+};
+
+/**
+ * @brief Maps a binary file and gives access to its declarations and types.
+ * @details Open checks the header, the trailer and the bounds of the sections. The records themselves
+ * are not checked, the file is trusted to be written by BinaryHandler. Top level declarations are
+ * walked with `for (uint32_t i = 0; i < reader.declarationCount(); i = reader.declaration(i).end())`,
+ * the members of a declaration d likewise from d.index() + 1 to d.end().
+ */
+class BinaryReader
+{
+public:
+  BinaryReader() : data_(nullptr), size_(0), mapped_(false) { std::memset(trailer_, 0, sizeof(trailer_)); }
+  ~BinaryReader() { Close(); }
+
+  // Do not allow copy or move
+  BinaryReader(const BinaryReader& other) = delete;
+  BinaryReader(BinaryReader&& other) = delete;
+
+  /// Maps the file at the given path
+  bool Open(const std::string& path)
+  {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+      return false;
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+      return false;
+    const std::size_t length = static_cast<std::size_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+      view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+      return false;
+    const std::size_t length = static_cast<std::size_t>(st.st_size);
+#endif
+    mapped_ = true;
+    if (!Open(static_cast<const char*>(view), length))
+    {
+      data_ = static_cast<const char*>(view);
+      size_ = length;
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  /// Reads a binary file that is already in memory. The memory has to stay valid while it is read.
+  bool Open(const char* data, std::size_t size)
+  {
+    const bool mapped = mapped_;
+    if (!mapped)
+      Close();
+    data_ = data;
+    size_ = size;
+    mapped_ = mapped;
+
+    static const std::size_t kMinimumSize = (kBinaryHeaderWords + kBinaryTrailerWords) * 4;
+    if (size < kMinimumSize || size % 4 != 0 || Word(0) != kBinaryMagic || Word(4) != kBinaryVersion)
+      return Fail();
+
+    for (uint32_t i = 0; i < kBinaryTrailerWords; ++i)
+      trailer_[i] = Word(size - (kBinaryTrailerWords - i) * 4);
+    if (trailer_[9] != kBinaryMagic || trailer_[8] != kBinaryVersion)
+      return Fail();
+
+    // Every section has to be within the file
+    const std::size_t end = size - kBinaryTrailerWords * 4;
+    if (!InBounds(trailer_[1], trailer_[0], kBinaryIndexWords * 4, end) ||
+        !InBounds(trailer_[3], trailer_[2], kBinaryTypeWords * 4, end) ||
+        !InBounds(trailer_[5], trailer_[4], kBinaryTypeArgumentWords * 4, end) ||
+        !InBounds(trailer_[7], trailer_[6], 1, end))
+      return Fail();
+
+    return true;
+  }
+
+  /// Unmaps the file
+  void Close()
+  {
+    if (mapped_ && data_ != nullptr)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    std::memset(trailer_, 0, sizeof(trailer_));
+  }
+
+  uint32_t declarationCount() const { return trailer_[0]; }
+  BinaryDeclaration declaration(uint32_t index) const { return BinaryDeclaration(*this, index); }
+
+  uint32_t typeCount() const { return trailer_[2]; }
+  BinaryType type(uint32_t id) const { return BinaryType(*this, id); }
+
+  /// Returns the little endian word at the given offset in bytes
+  uint32_t Word(std::size_t offset) const
+  {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data_ + offset);
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+  }
+
+  /// Returns the string stored at the given offset in bytes
+  BinaryString String(std::size_t offset) const
+  {
+    BinaryString str = { data_ + trailer_[7] + Word(offset), Word(offset + 4) };
+    return str;
+  }
+
+  /// Offsets of the sections
+  std::size_t indexOffset() const { return trailer_[1]; }
+  std::size_t typesOffset() const { return trailer_[3]; }
+  std::size_t typeArgumentsOffset() const { return trailer_[5]; }
+
+private:
+  bool Fail()
+  {
+    std::memset(trailer_, 0, sizeof(trailer_));
+    return false;
+  }
+
+  static bool InBounds(std::size_t offset, std::size_t count, std::size_t size, std::size_t end)
+  {
+    return offset <= end && count <= (end - offset) / size;
+  }
+
+  const char* data_;
+  std::size_t size_;
+  bool mapped_;
+  uint32_t trailer_[kBinaryTrailerWords];
+};
+
+//--------------------------------------------------------------------------------------------------
+inline uint32_t BinaryView::Word(std::size_t index) const
+{
+  return reader_->Word(offset_ + index * 4);
+}
+
+//--------------------------------------------------------------------------------------------------
+inline BinaryString BinaryView::String(std::size_t index) const
+{
+  return reader_->String(offset_ + index * 4);
+}
+
+//--------------------------------------------------------------------------------------------------
+inline BinaryDeclaration::BinaryDeclaration(const BinaryReader& reader, uint32_t index) :
+  BinaryView(reader, reader.Word(reader.indexOffset() + index * kBinaryIndexWords * 4)),
+  index_(index)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+inline uint32_t BinaryDeclaration::parent() const
+{
+  return reader_->Word(reader_->indexOffset() + (index_ * kBinaryIndexWords + 1) * 4);
+}
+
+//--------------------------------------------------------------------------------------------------
+inline uint32_t BinaryDeclaration::end() const
+{
+  return reader_->Word(reader_->indexOffset() + (index_ * kBinaryIndexWords + 2) * 4);
+}
+
+//--------------------------------------------------------------------------------------------------
+inline BinaryType::BinaryType(const BinaryReader& reader, uint32_t id) :
+  BinaryView(reader, reader.typesOffset() + id * kBinaryTypeWords * 4),
+  id_(id)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+inline BinaryTypeArgument BinaryType::argument(uint32_t i) const
+{
+  const uint32_t first = Word(kind() == BinaryTypeKind::kFunction ? 2 : 3);
+  return BinaryTypeArgument(*reader_, reader_->typeArgumentsOffset() + (first + i) * kBinaryTypeArgumentWords * 4);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+// Character classification tables used by the tokenizer. The tables are computed at compile time so
+// classifying a character is a single lookup that does not depend on the current locale.
+
+/// Character class bits
+enum CharClassBits : uint8_t
+{
+  /// [A-Za-z_]
+  kCharIdentifierStart = 1 << 0,
+
+  /// [A-Za-z0-9_]
+  kCharIdentifier = 1 << 1,
+
+  /// [0-9]
+  kCharDigit = 1 << 2,
+
+  /// Characters that start a number when followed by a digit: [+-.]
+  kCharNumberSign = 1 << 3,
+
+  /// White space as defined by std::isspace in the "C" locale
+  kCharSpace = 1 << 4,
+};
+
+namespace char_class_detail {
+  //------------------------------------------------------------------------------------------------
+  constexpr bool IsAlpha(unsigned c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  //------------------------------------------------------------------------------------------------
+  constexpr bool IsDigit(unsigned c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  //------------------------------------------------------------------------------------------------
+  constexpr uint8_t Classify(unsigned c)
+  {
+    return static_cast<uint8_t>(
+      (IsAlpha(c) || c == '_' ? kCharIdentifierStart | kCharIdentifier : 0) |
+      (IsDigit(c) ? kCharDigit | kCharIdentifier : 0) |
+      (c == '+' || c == '-' || c == '.' ? kCharNumberSign : 0) |
+      (c == ' ' || (c >= '\t' && c <= '\r') ? kCharSpace : 0));
+  }
+
+  // The two character operators form a two level DFA: the first character selects the set of
+  // characters that may follow it, every possible second character has a bit in that set.
+
+  //------------------------------------------------------------------------------------------------
+  constexpr uint8_t OperatorSecond(unsigned c)
+  {
+    return static_cast<uint8_t>(
+      c == '=' ? 1 << 0 :
+      c == '<' ? 1 << 1 :
+      c == '>' ? 1 << 2 :
+      c == '+' ? 1 << 3 :
+      c == '-' ? 1 << 4 :
+      c == '&' ? 1 << 5 :
+      c == '|' ? 1 << 6 :
+      c == ':' ? 1 << 7 : 0);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  constexpr uint8_t OperatorFirst(unsigned c)
+  {
+    return static_cast<uint8_t>(
+      c == '<' ? OperatorSecond('<') | OperatorSecond('=') :
+      c == '>' ? OperatorSecond('>') | OperatorSecond('=') :
+      c == '-' ? OperatorSecond('>') | OperatorSecond('-') | OperatorSecond('=') :
+      c == '+' ? OperatorSecond('+') | OperatorSecond('=') :
+      c == '&' ? OperatorSecond('&') | OperatorSecond('=') :
+      c == '|' ? OperatorSecond('|') | OperatorSecond('=') :
+      c == ':' ? OperatorSecond(':') :
+      c == '!' || c == '*' || c == '/' || c == '^' || c == '~' || c == '%' || c == '=' ? OperatorSecond('=') :
+      0);
+  }
+}
+
+#define HP_CHAR_TABLE_4(f, n) f(n), f(n + 1), f(n + 2), f(n + 3)
+#define HP_CHAR_TABLE_16(f, n) HP_CHAR_TABLE_4(f, n), HP_CHAR_TABLE_4(f, n + 4), HP_CHAR_TABLE_4(f, n + 8), HP_CHAR_TABLE_4(f, n + 12)
+#define HP_CHAR_TABLE_64(f, n) HP_CHAR_TABLE_16(f, n), HP_CHAR_TABLE_16(f, n + 16), HP_CHAR_TABLE_16(f, n + 32), HP_CHAR_TABLE_16(f, n + 48)
+#define HP_CHAR_TABLE_256(f) HP_CHAR_TABLE_64(f, 0u), HP_CHAR_TABLE_64(f, 64u), HP_CHAR_TABLE_64(f, 128u), HP_CHAR_TABLE_64(f, 192u)
+
+/// The CharClassBits of every character
+constexpr uint8_t kCharClasses[256] = { HP_CHAR_TABLE_256(char_class_detail::Classify) };
+
+/// The set of characters that can follow a character in a two character operator
+constexpr uint8_t kOperatorFirst[256] = { HP_CHAR_TABLE_256(char_class_detail::OperatorFirst) };
+
+/// The bit of a character in the sets of kOperatorFirst
+constexpr uint8_t kOperatorSecond[256] = { HP_CHAR_TABLE_256(char_class_detail::OperatorSecond) };
+
+#undef HP_CHAR_TABLE_256
+#undef HP_CHAR_TABLE_64
+#undef HP_CHAR_TABLE_16
+#undef HP_CHAR_TABLE_4
+
+/// Returns the CharClassBits of the character
+inline uint8_t CharClass(char c)
+{
+  return kCharClasses[static_cast<unsigned char>(c)];
+}
+
+/// Returns true if the character has any of the given CharClassBits
+inline bool HasCharClass(char c, uint8_t bits)
+{
+  return (kCharClasses[static_cast<unsigned char>(c)] & bits) != 0;
+}
+
+/// Returns true if the two characters form an operator such as "<=", "->" or "::"
+inline bool IsOperatorPair(char first, char second)
+{
+  return (kOperatorFirst[static_cast<unsigned char>(first)] & kOperatorSecond[static_cast<unsigned char>(second)]) != 0;
+}
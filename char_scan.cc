@@ -0,0 +1,491 @@
+#include "char_scan.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define HP_HAS_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define HP_HAS_AVX2 1
+#define HP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define HP_HAS_AVX2 1
+#define HP_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+  //------------------------------------------------------------------------------------------------
+  // Bit helpers
+  //------------------------------------------------------------------------------------------------
+  inline unsigned CountTrailingZeros(uint32_t mask)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    unsigned index = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      ++index;
+    }
+    return index;
+#endif
+  }
+
+  //------------------------------------------------------------------------------------------------
+  inline std::size_t PopCount(uint32_t mask)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcount(mask));
+#else
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return static_cast<std::size_t>((((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Scalar kernels
+  //------------------------------------------------------------------------------------------------
+  inline bool IsWhitespace(unsigned char c) { return c <= 0x20 || c == 0x7F; }
+  inline bool IsDigit(unsigned char c) { return static_cast<unsigned char>(c - '0') <= 9; }
+  inline bool IsIdentifier(unsigned char c)
+  {
+    return static_cast<unsigned char>((c | 0x20) - 'a') <= 25 || IsDigit(c) || c == '_';
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* SkipWhitespaceScalar(const char* first, const char* last)
+  {
+    while (first != last && IsWhitespace(static_cast<unsigned char>(*first)))
+      ++first;
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* ScanIdentifierScalar(const char* first, const char* last)
+  {
+    while (first != last && IsIdentifier(static_cast<unsigned char>(*first)))
+      ++first;
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* ScanDigitsScalar(const char* first, const char* last)
+  {
+    while (first != last && IsDigit(static_cast<unsigned char>(*first)))
+      ++first;
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindBlockCommentEndScalar(const char* first, const char* last)
+  {
+    for (; first + 1 < last; ++first)
+      if (first[0] == '*' && first[1] == '/')
+        return first;
+    return last;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindStringEndScalar(const char* first, const char* last, char closing)
+  {
+    while (first != last && *first != closing && *first != '\\')
+      ++first;
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  inline bool IsStructural(unsigned char c)
+  {
+    return c == '{' || c == '}' || c == ';' || c == '"' || c == '/' || c == '#' || c == 0xFF;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindStructuralScalar(const char* first, const char* last)
+  {
+    while (first != last && !IsStructural(static_cast<unsigned char>(*first)))
+      ++first;
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  std::size_t CountNewlinesScalar(const char* first, const char* last)
+  {
+    std::size_t count = 0;
+    for (; first != last; ++first)
+      count += *first == '\n';
+    return count;
+  }
+
+#ifdef HP_HAS_SSE2
+  //------------------------------------------------------------------------------------------------
+  // SSE2 kernels, 16 bytes per step
+  //------------------------------------------------------------------------------------------------
+  inline __m128i InRange128(__m128i v, char lo, char hi)
+  {
+    // (v - lo) <= (hi - lo) as an unsigned comparison
+    __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), offset);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  inline __m128i IsIdentifier128(__m128i v)
+  {
+    __m128i alpha = InRange128(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i digit = InRange128(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* SkipWhitespaceSSE2(const char* first, const char* last)
+  {
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      __m128i ws = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x20)), v),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(ws)) ^ 0xFFFFu;
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return SkipWhitespaceScalar(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* ScanIdentifierSSE2(const char* first, const char* last)
+  {
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(IsIdentifier128(v))) ^ 0xFFFFu;
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return ScanIdentifierScalar(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* ScanDigitsSSE2(const char* first, const char* last)
+  {
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(InRange128(v, '0', '9'))) ^ 0xFFFFu;
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return ScanDigitsScalar(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindBlockCommentEndSSE2(const char* first, const char* last)
+  {
+    for (; last - first >= 17; first += 16)
+    {
+      __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), _mm_set1_epi8('*'));
+      __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 1)), _mm_set1_epi8('/'));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(star, slash)));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindBlockCommentEndScalar(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindStringEndSSE2(const char* first, const char* last, char closing)
+  {
+    const __m128i closingVec = _mm_set1_epi8(closing);
+    const __m128i escapeVec = _mm_set1_epi8('\\');
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, closingVec), _mm_cmpeq_epi8(v, escapeVec))));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindStringEndScalar(first, last, closing);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const char* FindStructuralSSE2(const char* first, const char* last)
+  {
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      __m128i structural = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8(';')));
+      __m128i other = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('/'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')), _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xFF)))));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(structural, other)));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindStructuralScalar(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  std::size_t CountNewlinesSSE2(const char* first, const char* last)
+  {
+    std::size_t count = 0;
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; last - first >= 16; first += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+      count += PopCount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))));
+    }
+    return count + CountNewlinesScalar(first, last);
+  }
+#endif
+
+#ifdef HP_HAS_AVX2
+  //------------------------------------------------------------------------------------------------
+  // AVX2 kernels, 32 bytes per step
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 inline __m256i InRange256(__m256i v, char lo, char hi)
+  {
+    __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(hi - lo))), offset);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* SkipWhitespaceAVX2(const char* first, const char* last)
+  {
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      __m256i ws = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x20)), v),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7F)));
+      uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return SkipWhitespaceSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* ScanIdentifierAVX2(const char* first, const char* last)
+  {
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      __m256i alpha = InRange256(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+      __m256i digit = InRange256(v, '0', '9');
+      __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+      uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore)));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return ScanIdentifierSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* ScanDigitsAVX2(const char* first, const char* last)
+  {
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(InRange256(v, '0', '9')));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return ScanDigitsSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* FindBlockCommentEndAVX2(const char* first, const char* last)
+  {
+    for (; last - first >= 33; first += 32)
+    {
+      __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)), _mm256_set1_epi8('*'));
+      __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + 1)), _mm256_set1_epi8('/'));
+      uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(star, slash)));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindBlockCommentEndSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* FindStringEndAVX2(const char* first, const char* last, char closing)
+  {
+    const __m256i closingVec = _mm256_set1_epi8(closing);
+    const __m256i escapeVec = _mm256_set1_epi8('\\');
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, closingVec), _mm256_cmpeq_epi8(v, escapeVec))));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindStringEndSSE2(first, last, closing);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 const char* FindStructuralAVX2(const char* first, const char* last)
+  {
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      __m256i structural = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}'))),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(';')));
+      __m256i other = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('#')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(0xFF)))));
+      uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(structural, other)));
+      if (mask != 0)
+        return first + CountTrailingZeros(mask);
+    }
+    return FindStructuralSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  HP_TARGET_AVX2 std::size_t CountNewlinesAVX2(const char* first, const char* last)
+  {
+    std::size_t count = 0;
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; last - first >= 32; first += 32)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+      count += PopCount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline))));
+    }
+    return count + CountNewlinesSSE2(first, last);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  bool CpuSupportsAVX2()
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+      return false;
+
+    // The OS has to save the YMM registers for AVX to be usable
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+      return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+  }
+#endif
+
+  //------------------------------------------------------------------------------------------------
+  // Runtime dispatch
+  //------------------------------------------------------------------------------------------------
+  struct ScanKernels
+  {
+    const char* name;
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*scanIdentifier)(const char*, const char*);
+    const char* (*scanDigits)(const char*, const char*);
+    const char* (*findBlockCommentEnd)(const char*, const char*);
+    const char* (*findStringEnd)(const char*, const char*, char);
+    const char* (*findStructural)(const char*, const char*);
+    std::size_t (*countNewlines)(const char*, const char*);
+  };
+
+  //------------------------------------------------------------------------------------------------
+  ScanKernels SelectKernels()
+  {
+#ifdef HP_HAS_AVX2
+    if (CpuSupportsAVX2())
+      return ScanKernels { "avx2", SkipWhitespaceAVX2, ScanIdentifierAVX2, ScanDigitsAVX2,
+        FindBlockCommentEndAVX2, FindStringEndAVX2, FindStructuralAVX2, CountNewlinesAVX2 };
+#endif
+#ifdef HP_HAS_SSE2
+    return ScanKernels { "sse2", SkipWhitespaceSSE2, ScanIdentifierSSE2, ScanDigitsSSE2,
+      FindBlockCommentEndSSE2, FindStringEndSSE2, FindStructuralSSE2, CountNewlinesSSE2 };
+#else
+    return ScanKernels { "scalar", SkipWhitespaceScalar, ScanIdentifierScalar, ScanDigitsScalar,
+      FindBlockCommentEndScalar, FindStringEndScalar, FindStructuralScalar, CountNewlinesScalar };
+#endif
+  }
+
+  //------------------------------------------------------------------------------------------------
+  const ScanKernels& Kernels()
+  {
+    static const ScanKernels kernels = SelectKernels();
+    return kernels;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* SkipWhitespace(const char* first, const char* last)
+{
+  return Kernels().skipWhitespace(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* ScanIdentifier(const char* first, const char* last)
+{
+  return Kernels().scanIdentifier(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* ScanDigits(const char* first, const char* last)
+{
+  return Kernels().scanDigits(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* FindNewline(const char* first, const char* last)
+{
+  // The C library memchr is already vectorized on every platform we care about
+  const void* result = std::memchr(first, '\n', static_cast<std::size_t>(last - first));
+  return result != nullptr ? static_cast<const char*>(result) : last;
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* FindBlockCommentEnd(const char* first, const char* last)
+{
+  return Kernels().findBlockCommentEnd(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* FindStringEnd(const char* first, const char* last, char closing)
+{
+  return Kernels().findStringEnd(first, last, closing);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* FindStructural(const char* first, const char* last)
+{
+  return Kernels().findStructural(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+std::size_t CountNewlines(const char* first, const char* last)
+{
+  return Kernels().countNewlines(first, last);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* ScanKernelName()
+{
+  return Kernels().name;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+// Character scanning kernels used by the tokenizer for its hot loops. Every kernel scans the range
+// [first, last) and returns a pointer to the first character that stops the scan, or last if there is
+// none. The fastest implementation supported by the CPU (AVX2, SSE2 or plain scalar code) is selected
+// at runtime the first time a kernel is used.
+
+/// Returns the first character that is neither white space nor a control character.
+const char* SkipWhitespace(const char* first, const char* last);
+
+/// Returns the first character that cannot be part of an identifier ([A-Za-z0-9_]).
+const char* ScanIdentifier(const char* first, const char* last);
+
+/// Returns the first character that is not a decimal digit.
+const char* ScanDigits(const char* first, const char* last);
+
+/// Returns the first new line character.
+const char* FindNewline(const char* first, const char* last);
+
+/// Returns the '*' of the first "*/" sequence.
+const char* FindBlockCommentEnd(const char* first, const char* last);
+
+/// Returns the first occurrence of the closing character or of a backslash.
+const char* FindStringEnd(const char* first, const char* last, char closing);
+
+/// Returns the first character that may start a structural token, a string, a comment or a directive:
+/// a brace, ';', '"', '/', '#' or the end of file marker 0xFF.
+const char* FindStructural(const char* first, const char* last);
+
+/// Returns the number of new line characters in the range.
+std::size_t CountNewlines(const char* first, const char* last);
+
+/// Returns the name of the selected kernel implementation ("avx2", "sse2" or "scalar").
+const char* ScanKernelName();
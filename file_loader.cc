@@ -0,0 +1,480 @@
+#include "file_loader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define HEADER_PARSER_IO_URING 1
+#endif
+#endif
+#endif
+
+namespace {
+  /// Number of threads that read ahead if io_uring is not available
+  const unsigned kReaderThreads = 4;
+
+  /// Number of files that are opened or read through io_uring at the same time
+  const unsigned kRingEntries = 64;
+
+  //------------------------------------------------------------------------------------------------
+  /// Reads the file at the given path into buffer. The buffer is sized for the expected size up front
+  /// and grows if the file is larger.
+  bool ReadFile(const std::string& path, uint64_t size, std::vector<char>& buffer)
+  {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if (fd < 0)
+      return false;
+
+    buffer.resize(static_cast<std::size_t>(size) + 1);
+    std::size_t length = 0;
+    bool result = true;
+    for (;;)
+    {
+      if (length == buffer.size())
+        buffer.resize(buffer.size() * 2);
+
+#ifdef _WIN32
+      int bytesRead = _read(fd, buffer.data() + length, static_cast<unsigned>(buffer.size() - length));
+#else
+      ssize_t bytesRead = read(fd, buffer.data() + length, buffer.size() - length);
+#endif
+      if (bytesRead < 0 && errno == EINTR)
+        continue;
+
+      if (bytesRead <= 0)
+      {
+        result = bytesRead == 0;
+        break;
+      }
+
+      length += static_cast<std::size_t>(bytesRead);
+    }
+
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    buffer.resize(length);
+    return result;
+  }
+}
+
+#ifdef HEADER_PARSER_IO_URING
+//--------------------------------------------------------------------------------------------------
+/// A minimal io_uring instance on top of the system calls, so liburing is not required
+struct FileLoader::Ring
+{
+  Ring() :
+    fd(-1),
+    sqRing(MAP_FAILED),
+    cqRing(MAP_FAILED),
+    sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+    queued(0) {}
+
+  ~Ring()
+  {
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+      munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+      munmap(sqRing, sqRingSize);
+    if (fd >= 0)
+      close(fd);
+  }
+
+  /// Sets up the rings, returns false if io_uring or the operations that are used are not supported
+  bool Open(unsigned entries)
+  {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0)
+      return false;
+
+    // Opening and reading through io_uring requires Linux 5.6, ask the kernel whether it can
+    std::vector<uint64_t> storage((sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+        probe->last_op < IORING_OP_READ ||
+        (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) == 0 ||
+        (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) == 0)
+      return false;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+      sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+      return false;
+    cqRing = singleMap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+      return false;
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+      return false;
+
+    char* sq = static_cast<char*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /// Queues an operation, returns nullptr if the submission queue is full
+  io_uring_sqe* Queue(uint8_t opcode, uint64_t userData)
+  {
+    const unsigned tail = *sqTail;
+    if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+      return nullptr;
+
+    io_uring_sqe* sqe = &sqes[tail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->user_data = userData;
+    sqArray[tail & sqMask] = tail & sqMask;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++queued;
+    return sqe;
+  }
+
+  /// Submits the queued operations and waits for at least one to complete
+  bool Submit()
+  {
+    for (;;)
+    {
+      const long submitted = syscall(__NR_io_uring_enter, fd, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (submitted >= 0)
+      {
+        queued -= static_cast<unsigned>(submitted);
+        return true;
+      }
+      if (errno != EINTR)
+        return false;
+    }
+  }
+
+  /// Calls handle for every completed operation
+  template<typename Handler>
+  void Complete(Handler handle)
+  {
+    unsigned head = *cqHead;
+    const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+      const io_uring_cqe& cqe = cqes[head & cqMask];
+      handle(cqe.user_data, cqe.res);
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+  }
+
+  int fd;
+  void* sqRing;
+  void* cqRing;
+  io_uring_sqe* sqes;
+  std::size_t sqRingSize;
+  std::size_t cqRingSize;
+  std::size_t sqesSize;
+
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqArray;
+  unsigned sqMask;
+  unsigned sqEntries;
+
+  unsigned* cqHead;
+  unsigned* cqTail;
+  io_uring_cqe* cqes;
+  unsigned cqMask;
+
+  /// Number of operations that were queued but not submitted yet
+  unsigned queued;
+
+  /// Buffers of operations that were given up on after an error
+  std::vector<std::vector<char>> abandoned;
+};
+#else
+struct FileLoader::Ring
+{
+};
+#endif
+
+//--------------------------------------------------------------------------------------------------
+FileLoader::FileLoader(const std::vector<std::string>& paths, const std::vector<uint64_t>& sizes, std::size_t windowSize) :
+  paths_(paths),
+  sizes_(sizes),
+  windowSize_(windowSize),
+  next_(0),
+  states_(paths.size(), State::kQueued),
+  contents_(paths.size()),
+  windowUsed_(0),
+  stop_(false),
+  ioUring_(false)
+{
+  // Same order as TaskScheduler, the largest files first
+  order_.resize(paths.size());
+  std::iota(order_.begin(), order_.end(), std::size_t(0));
+  std::stable_sort(order_.begin(), order_.end(), [&sizes](std::size_t a, std::size_t b) { return sizes[a] > sizes[b]; });
+
+  if (paths.empty())
+    return;
+
+#ifdef HEADER_PARSER_IO_URING
+  ring_.reset(new Ring);
+  ioUring_ = ring_->Open(kRingEntries);
+  if (ioUring_)
+  {
+    threads_.emplace_back(&FileLoader::RunIoUring, this);
+    return;
+  }
+  ring_.reset();
+#endif
+
+  const unsigned threadCount = static_cast<unsigned>(std::min<std::size_t>(kReaderThreads, paths.size()));
+  for (unsigned i = 0; i < threadCount; ++i)
+    threads_.emplace_back(&FileLoader::RunReader, this);
+}
+
+//--------------------------------------------------------------------------------------------------
+FileLoader::~FileLoader()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+
+  for (std::thread& thread : threads_)
+    thread.join();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool FileLoader::Take(std::size_t index, std::vector<char>& buffer)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this, index]() { return states_[index] != State::kReading; });
+
+  const State state = states_[index];
+  states_[index] = State::kTaken;
+  if (state != State::kRead)
+    return false;
+
+  buffer.swap(contents_[index]);
+  std::vector<char>().swap(contents_[index]);
+  windowUsed_ -= static_cast<std::size_t>(sizes_[index]);
+  changed_.notify_all();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool FileLoader::Next(std::size_t& index)
+{
+  // Files that were taken already are read by the thread that took them, files of unknown size as well
+  while (next_ != order_.size() && (states_[order_[next_]] != State::kQueued || sizes_[order_[next_]] == 0))
+    ++next_;
+  if (next_ == order_.size())
+    return false;
+
+  // A file larger than the window is read once the window is empty
+  const std::size_t size = static_cast<std::size_t>(sizes_[order_[next_]]);
+  if (windowUsed_ != 0 && windowUsed_ + size > windowSize_)
+    return false;
+
+  index = order_[next_++];
+  states_[index] = State::kReading;
+  windowUsed_ += size;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void FileLoader::Finish(std::size_t index, bool succeeded)
+{
+  if (succeeded)
+    states_[index] = State::kRead;
+  else
+  {
+    states_[index] = State::kFailed;
+    std::vector<char>().swap(contents_[index]);
+    windowUsed_ -= static_cast<std::size_t>(sizes_[index]);
+  }
+  changed_.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+void FileLoader::RunReader()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;)
+  {
+    std::size_t index;
+    while (!stop_ && !Next(index))
+    {
+      if (next_ == order_.size())
+        return;
+      changed_.wait(lock);
+    }
+    if (stop_)
+      return;
+
+    // The file is not touched by other threads while it is being read
+    lock.unlock();
+    const bool succeeded = ReadFile(paths_[index], sizes_[index], contents_[index]);
+    lock.lock();
+    Finish(index, succeeded);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void FileLoader::RunIoUring()
+{
+#ifdef HEADER_PARSER_IO_URING
+  Ring& ring = *ring_;
+
+  // Every file that is being read has one operation in flight: its open, or a read of the remainder
+  std::vector<int> fds(paths_.size(), -1);
+  std::vector<std::size_t> lengths(paths_.size(), 0);
+  std::vector<std::size_t> started;
+  unsigned inFlight = 0;
+
+  auto queueRead = [&](std::size_t index)
+  {
+    std::vector<char>& buffer = contents_[index];
+    if (lengths[index] == buffer.size())
+      buffer.resize(buffer.size() * 2);
+
+    io_uring_sqe* sqe = ring.Queue(IORING_OP_READ, index << 1 | 1);
+    sqe->fd = fds[index];
+    sqe->addr = reinterpret_cast<uint64_t>(buffer.data() + lengths[index]);
+    sqe->len = static_cast<uint32_t>(std::min<std::size_t>(buffer.size() - lengths[index], UINT32_MAX));
+    sqe->off = lengths[index];
+  };
+
+  auto finish = [&](std::size_t index, bool succeeded)
+  {
+    if (fds[index] >= 0)
+      close(fds[index]);
+    fds[index] = -1;
+    contents_[index].resize(succeeded ? lengths[index] : 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Finish(index, succeeded);
+    --inFlight;
+  };
+
+  for (;;)
+  {
+    // Start reading the next files while the window and the ring allow it. With one operation per file
+    // the submission queue never overflows.
+    started.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (;;)
+      {
+        std::size_t index;
+        while (!stop_ && inFlight + started.size() < kRingEntries && Next(index))
+          started.push_back(index);
+        if (stop_ || inFlight != 0 || !started.empty() || next_ == order_.size())
+          break;
+        changed_.wait(lock);
+      }
+    }
+    if (started.empty() && inFlight == 0)
+      return;
+
+    // The buffer has room for one more byte than expected, so a file that grew is noticed
+    for (std::size_t index : started)
+    {
+      contents_[index].resize(static_cast<std::size_t>(sizes_[index]) + 1);
+      lengths[index] = 0;
+      io_uring_sqe* sqe = ring.Queue(IORING_OP_OPENAT, index << 1);
+      sqe->fd = AT_FDCWD;
+      sqe->addr = reinterpret_cast<uint64_t>(paths_[index].c_str());
+      sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    }
+    inFlight += static_cast<unsigned>(started.size());
+
+    if (!ring.Submit())
+    {
+      // Leave the files in flight to the threads that take them. The kernel may still write to their
+      // buffers, so these stay alive as long as the ring does.
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (std::size_t index = 0; index < paths_.size(); ++index)
+      {
+        if (states_[index] != State::kReading)
+          continue;
+        if (fds[index] >= 0)
+          close(fds[index]);
+        ring.abandoned.push_back(std::move(contents_[index]));
+        Finish(index, false);
+      }
+      return;
+    }
+
+    ring.Complete([&](uint64_t userData, int32_t result)
+    {
+      const std::size_t index = static_cast<std::size_t>(userData >> 1);
+      if ((userData & 1) == 0)
+      {
+        // Opened
+        if (result < 0)
+          finish(index, false);
+        else
+        {
+          fds[index] = result;
+          queueRead(index);
+        }
+        return;
+      }
+
+      if (result == -EINTR || result == -EAGAIN)
+      {
+        queueRead(index);
+        return;
+      }
+      if (result < 0)
+      {
+        finish(index, false);
+        return;
+      }
+
+      // Read until the end of the file, which is usually the first read returning the expected size
+      lengths[index] += static_cast<std::size_t>(result);
+      if (result == 0 || lengths[index] == sizes_[index])
+        finish(index, true);
+      else
+        queueRead(index);
+    });
+  }
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Reads files into memory ahead of the threads that parse them.
+ * @details The files are read from the largest down, the order in which TaskScheduler hands them out,
+ * and at most windowSize bytes are read ahead of the files that were taken. On Linux the opens and
+ * reads are submitted in batches through io_uring, so the kernel works on many files at once while the
+ * files read so far are parsed. Where io_uring is not available a few threads read ahead instead.
+ *
+ * A file that is taken before it was read, and files whose size is unknown, are read by the thread
+ * that takes them.
+ */
+class FileLoader
+{
+public:
+  /// Starts reading the files at the given paths, of which the sizes are known in advance
+  FileLoader(const std::vector<std::string>& paths, const std::vector<uint64_t>& sizes, std::size_t windowSize);
+
+  /// Stops reading and waits for reads in progress
+  ~FileLoader();
+
+  // Do not allow copy or move
+  FileLoader(const FileLoader& other) = delete;
+  FileLoader(FileLoader&& other) = delete;
+
+  /// Moves the contents of the file with the given index into buffer, waiting for them if the file is
+  /// being read. Returns false if the file was not read, the caller has to read it itself then.
+  bool Take(std::size_t index, std::vector<char>& buffer);
+
+  /// Returns true if the files are read through io_uring
+  bool usesIoUring() const { return ioUring_; }
+
+private:
+  enum class State : uint8_t
+  {
+    kQueued,
+    kReading,
+    kRead,
+    kFailed,
+    kTaken
+  };
+
+  /// Returns the index of the next file to read, or false if there is none or the window is full.
+  /// Has to be called with mutex_ locked.
+  bool Next(std::size_t& index);
+
+  /// Stores the result of reading a file. Has to be called with mutex_ locked.
+  void Finish(std::size_t index, bool succeeded);
+
+  /// Reads files through ring_ until all are read
+  void RunIoUring();
+
+  /// Reads files with blocking reads until all are read
+  void RunReader();
+
+private:
+  const std::vector<std::string>& paths_;
+  const std::vector<uint64_t>& sizes_;
+  std::size_t windowSize_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+
+  /// The files in the order they are read, and the position of the next one to read
+  std::vector<std::size_t> order_;
+  std::size_t next_;
+
+  std::vector<State> states_;
+  std::vector<std::vector<char>> contents_;
+
+  /// Number of bytes read or being read that were not taken yet
+  std::size_t windowUsed_;
+
+  bool stop_;
+  bool ioUring_;
+
+  /// The io_uring instance, if io_uring is available
+  struct Ring;
+  std::unique_ptr<Ring> ring_;
+
+  std::vector<std::thread> threads_;
+};
@@ -0,0 +1,166 @@
+#include "file_watcher.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  /// Changes are reported once no change followed for this long
+  const std::chrono::milliseconds kQuietPeriod(2);
+
+  /// Changes are reported after this long even if more keep coming
+  const std::chrono::milliseconds kMaxDelay(50);
+}
+
+//--------------------------------------------------------------------------------------------------
+FileWatcher::FileWatcher() :
+  fd_(-1)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+  if (fd_ >= 0)
+    close(fd_);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+bool FileWatcher::Open()
+{
+#ifdef __linux__
+  fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  return fd_ >= 0;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+bool FileWatcher::Watch(const std::string& directory)
+{
+#ifdef __linux__
+  // Files that are written, and files and directories that appear or disappear. A directory that is
+  // moved keeps its watch descriptor, which then gets the new path.
+  const uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+  const int wd = inotify_add_watch(fd_, directory.empty() ? "." : directory.c_str(), mask);
+  if (wd < 0)
+    return false;
+
+  directories_[wd] = directory;
+  return true;
+#else
+  (void)directory;
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+void FileWatcher::Unwatch(const std::string& directory)
+{
+#ifdef __linux__
+  for (auto i = directories_.begin(); i != directories_.end();)
+  {
+    const std::string& path = i->second;
+    if (path.compare(0, directory.size(), directory) == 0 &&
+        (path.size() == directory.size() || path[directory.size()] == '/' || directory.empty()))
+    {
+      inotify_rm_watch(fd_, i->first);
+      i = directories_.erase(i);
+    }
+    else
+      ++i;
+  }
+#else
+  (void)directory;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+bool FileWatcher::Wait(std::vector<Change>& changes, bool& overflowed)
+{
+  changes.clear();
+  overflowed = false;
+
+#ifdef __linux__
+  typedef std::chrono::steady_clock Clock;
+
+  // Events are aligned like the structure that precedes their names
+  alignas(inotify_event) char buffer[64 * 1024];
+  Clock::time_point first;
+  for (;;)
+  {
+    // Block until the first change, then wait for the changes to stop
+    int timeout = -1;
+    if (!changes.empty() || overflowed)
+    {
+      const Clock::time_point now = Clock::now();
+      if (now - first >= kMaxDelay)
+        return true;
+      timeout = static_cast<int>(std::min(kQuietPeriod, std::chrono::duration_cast<std::chrono::milliseconds>(first + kMaxDelay - now)).count());
+    }
+
+    pollfd descriptor = { fd_, POLLIN, 0 };
+    const int ready = poll(&descriptor, 1, timeout);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready < 0)
+      return false;
+    if (ready == 0)
+      return true;
+
+    for (;;)
+    {
+      const ssize_t length = read(fd_, buffer, sizeof(buffer));
+      if (length < 0 && errno == EINTR)
+        continue;
+      if (length < 0 && errno == EAGAIN)
+        break;
+      if (length <= 0)
+        return false;
+
+      if (changes.empty() && !overflowed)
+        first = Clock::now();
+
+      for (const char* data = buffer; data < buffer + length;)
+      {
+        const inotify_event& event = *reinterpret_cast<const inotify_event*>(data);
+        data += sizeof(inotify_event) + event.len;
+
+        if ((event.mask & IN_Q_OVERFLOW) != 0)
+        {
+          overflowed = true;
+          continue;
+        }
+
+        auto directory = directories_.find(event.wd);
+        if (directory == directories_.end())
+          continue;
+
+        // The directory itself was removed
+        if ((event.mask & IN_IGNORED) != 0)
+        {
+          directories_.erase(directory);
+          continue;
+        }
+        if (event.len == 0)
+          continue;
+
+        const bool isDirectory = (event.mask & IN_ISDIR) != 0;
+        const bool removed = (event.mask & (IN_DELETE | IN_MOVED_FROM)) != 0;
+        changes.push_back({ directory->second, event.name, isDirectory, removed });
+      }
+    }
+  }
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Reports changes to the files in a set of directories.
+ * @details Directories are watched through inotify, so this is only supported on Linux. Editors often
+ * save a file in several steps, writing a temporary file and renaming it over the original for
+ * example, so Wait collects changes until none followed for a few milliseconds and reports them
+ * together. A file may be reported more than once.
+ */
+class FileWatcher
+{
+public:
+  /// A file or directory in a watched directory that changed
+  struct Change
+  {
+    /// The path of the watched directory, as it was passed to Watch
+    std::string directory;
+    std::string name;
+    bool isDirectory;
+
+    /// True if the file or directory was deleted or moved away
+    bool removed;
+  };
+
+  FileWatcher();
+  ~FileWatcher();
+
+  // Do not allow copy or move
+  FileWatcher(const FileWatcher& other) = delete;
+  FileWatcher(FileWatcher&& other) = delete;
+
+  /// Starts watching, returns false if watching is not supported
+  bool Open();
+
+  /// Watches the files in the directory at the given path, an empty path is the working directory
+  bool Watch(const std::string& directory);
+
+  /// Stops watching the directory at the given path and the directories below it
+  void Unwatch(const std::string& directory);
+
+  /// Waits for changes and returns them. overflowed is set if changes were lost, in which case any file
+  /// may have changed. Returns false if waiting failed.
+  bool Wait(std::vector<Change>& changes, bool& overflowed);
+
+private:
+  int fd_;
+
+  /// The path of every watched directory by watch descriptor
+  std::unordered_map<int, std::string> directories_;
+};
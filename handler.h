@@ -1,83 +1,229 @@
 #pragma once
 
-#include <string>
+#include "token.h"
+#include "type_node.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // ----------------------------------------------------------------------------------------------------
 
-enum AccessSpecifierType
+enum class AccessControlType
 {
-    PUBLIC,
-    PROTECTED,
-    PRIVATE
+    kPublic,
+    kPrivate,
+    kProtected
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-typedef std::string Type;
+/**
+ * @brief An entry of the arguments of an annotation macro.
+ * @details The arguments are stored as a flat list. An entry of the form key(...) is followed by the
+ * entries of its nested sequence, count tells how many entries that are in total.
+ */
+struct MetaEntry
+{
+    enum class Type : uint8_t
+    {
+        kNull,
+        kValue,
+        kSequence
+    };
+
+    Type type;
+    StringView key;
+
+    /// The value of a key=value entry
+    Token value;
+
+    /// Number of entries that follow and belong to the nested sequence of a key(...) entry
+    std::size_t count;
+};
 
 // ----------------------------------------------------------------------------------------------------
 
-struct FieldInfo
+/// The properties all annotated declarations have in common
+struct DeclarationInfo
 {
-    std::string name;
-    Type type;
-    AccessSpecifierType access_specifier;
+    /// Line of the annotation macro
+    std::size_t line;
+
+    /// True if the declaration is a member of a class, access is only set in that case
+    bool isMember;
+    AccessControlType access;
+
+    /// The comment directly preceding the annotation. Only classes, functions and constructors
+    /// collect comments, it is empty for the other declarations.
+    StringView comment;
+
+    /// The arguments of the annotation macro
+    const MetaEntry* meta;
+    std::size_t metaCount;
+
+    /// The type trees of the declaration. The type fields of the declarations are indices of the root
+    /// nodes of the types in this tree.
+    const TypeTree* types;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-struct ArgumentInfo
+struct IncludeInfo
 {
-    std::string name;
-    Type type;
+    StringView file;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-struct FunctionInfo
+struct NamespaceInfo
 {
-    std::string name;
-    Type return_type;
-    std::vector<ArgumentInfo> arguments;
-    bool is_const;
+    StringView name;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-struct EnumInfo
+struct TemplateArgumentInfo
 {
-    std::string name;
-    std::vector<std::string> enumerators;
+    /// Either class or typename
+    StringView typeParameterKey;
+    StringView name;
+
+    /// The default type, kNoTypeNode if there is none
+    uint32_t defaultType;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-struct ClassInfo
+struct ParentInfo
 {
-    std::string name;
-    std::vector<FunctionInfo> methods;
-    std::vector<FieldInfo> fields;
+    AccessControlType access;
+    uint32_t type;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct ClassInfo : DeclarationInfo
+{
+    bool isTemplate;
+    std::vector<TemplateArgumentInfo> templateArguments;
+
+    bool isStruct;
+    StringView name;
+    std::vector<ParentInfo> parents;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct EnumeratorInfo
+{
+    StringView key;
+
+    /// The text of the initializer, empty if there is none
+    bool hasValue;
+    StringView value;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct EnumInfo : DeclarationInfo
+{
+    StringView name;
+    bool isEnumClass;
+
+    /// The underlying type of an enum class, empty if there is none
+    StringView base;
+
+    std::vector<EnumeratorInfo> members;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct PropertyInfo : DeclarationInfo
+{
+    bool isMutable;
+    bool isStatic;
+    uint32_t dataType;
+    StringView name;
+
+    /// The number of elements of an array, as written
+    bool isArray;
+    StringView elements;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct ArgumentInfo
+{
+    uint32_t type;
+    StringView name;
+
+    /// The default value. A single constant is stored as such, any other expression is stored as its
+    /// text with the token type kNone.
+    bool hasDefaultValue;
+    Token defaultValue;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct FunctionInfo : DeclarationInfo
+{
+    /// The annotation macro of the function
+    StringView macro;
+
+    bool isVirtual;
+    bool isInline;
+    bool isConstExpr;
+    bool isStatic;
+
+    uint32_t returnType;
+    StringView name;
+    std::vector<ArgumentInfo> arguments;
+
+    bool isConst;
+    bool isAbstract;
+};
+
+// ----------------------------------------------------------------------------------------------------
+
+struct ConstructorInfo : DeclarationInfo
+{
+    bool isInline;
+    StringView name;
+    std::vector<ArgumentInfo> arguments;
+    bool isDefault;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
-struct StructInfo
+struct MacroInfo : DeclarationInfo
 {
-    std::string name;
-    std::vector<FunctionInfo> methods;
-    std::vector<FieldInfo> fields;
+    /// The name of the custom macro
+    StringView name;
 };
 
 // ----------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Receives the declarations found by the parser, in the order they appear in the input.
+ * @details The members of namespaces and classes are reported between the Start and End calls of their
+ * scope. The info passed to a call, and all text it refers to, is only valid during the call. If the
+ * input contains an error the parser stops and the remaining End calls are not made.
+ */
 class Handler
 {
 
 public:
 
-    virtual void Class(const ClassInfo& info) {}
-    virtual void Struct(const StructInfo& info) {}
-    virtual void Function(const FunctionInfo& info) {}
-    virtual void Enum(const EnumInfo& info) {}
+    virtual ~Handler() {}
+
+    virtual void Include(const IncludeInfo& /*info*/) {}
+    virtual void StartNamespace(const NamespaceInfo& /*info*/) {}
+    virtual void EndNamespace() {}
+    virtual void StartClass(const ClassInfo& /*info*/) {}
+    virtual void EndClass() {}
+    virtual void Enum(const EnumInfo& /*info*/) {}
+    virtual void Property(const PropertyInfo& /*info*/) {}
+    virtual void Function(const FunctionInfo& /*info*/) {}
+    virtual void Constructor(const ConstructorInfo& /*info*/) {}
+    virtual void Macro(const MacroInfo& /*info*/) {}
 };
@@ -0,0 +1,130 @@
+#include "input_file.h"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+InputFile::InputFile() :
+  data_(nullptr),
+  size_(0),
+  mapped_(false)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+InputFile::~InputFile()
+{
+  Close();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputFile::Open(const std::string& path)
+{
+  Close();
+
+#ifdef _WIN32
+  int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+  if (fd < 0)
+    return false;
+
+  bool result = ReadAll(fd);
+  _close(fd);
+  return result;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  // Map regular files, everything else has to be read
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+#ifdef MADV_SEQUENTIAL
+      madvise(mapping, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+#endif
+      close(fd);
+      data_ = static_cast<const char*>(mapping);
+      size_ = static_cast<std::size_t>(st.st_size);
+      mapped_ = true;
+      return true;
+    }
+  }
+
+  bool result = ReadAll(fd);
+  close(fd);
+  return result;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+void InputFile::Open(std::vector<char>& contents)
+{
+  Close();
+
+  buffer_.swap(contents);
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+void InputFile::Close()
+{
+#ifndef _WIN32
+  if (mapped_)
+    munmap(const_cast<char*>(data_), size_);
+#endif
+
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  buffer_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputFile::ReadAll(int fd)
+{
+  static const std::size_t kChunkSize = 64 * 1024;
+
+  std::size_t length = 0;
+  for (;;)
+  {
+    if (buffer_.size() < length + kChunkSize)
+      buffer_.resize(length + kChunkSize);
+
+#ifdef _WIN32
+    int bytesRead = _read(fd, buffer_.data() + length, static_cast<unsigned>(kChunkSize));
+#else
+    ssize_t bytesRead = read(fd, buffer_.data() + length, kChunkSize);
+#endif
+    if (bytesRead < 0 && errno == EINTR)
+      continue;
+
+    if (bytesRead < 0)
+    {
+      buffer_.clear();
+      return false;
+    }
+
+    if (bytesRead == 0)
+      break;
+
+    length += static_cast<std::size_t>(bytesRead);
+  }
+
+  buffer_.resize(length);
+  data_ = buffer_.data();
+  size_ = length;
+  return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class InputFile
+{
+public:
+  InputFile();
+  ~InputFile();
+
+  // Do not allow copy or move
+  InputFile(const InputFile& other) = delete;
+  InputFile(InputFile&& other) = delete;
+
+  /**
+   * @brief Opens the file at the given path.
+   * @details Regular files are memory mapped so the tokenizer runs directly on the page cache. Anything
+   * that cannot be mapped (pipes, character devices, empty files) is read into an internal buffer instead.
+   */
+  bool Open(const std::string& path);
+
+  /// Takes over contents that were read already, leaving the previous buffer in contents
+  void Open(std::vector<char>& contents);
+
+  /// Releases the mapping or buffer of a previously opened file
+  void Close();
+
+  /// Returns the contents of the file. The contents are not NUL terminated.
+  const char* data() const { return data_; }
+
+  /// Returns the size of the file contents in bytes
+  std::size_t size() const { return size_; }
+
+private:
+  /// Reads the remainder of the given file descriptor into the buffer
+  bool ReadAll(int fd);
+
+private:
+  const char* data_;
+  std::size_t size_;
+
+  /// True if data_ points to a memory mapping that has to be unmapped
+  bool mapped_;
+
+  /// Storage used when the file could not be mapped
+  std::vector<char> buffer_;
+};
@@ -0,0 +1,329 @@
+#include "input_list.h"
+#include "input_file.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+  /// Response files may name other response files up to this depth
+  const int kMaxResponseFileDepth = 16;
+
+  /// Upper bound of the number of threads that walk a directory
+  const unsigned kMaxWalkThreads = 8;
+
+  //------------------------------------------------------------------------------------------------
+  /// Matches a glob pattern against text, see InputList
+  bool MatchGlob(const char* pattern, const char* text)
+  {
+    for (; *pattern != '\0'; ++pattern, ++text)
+    {
+      if (*pattern == '*')
+      {
+        const bool crossSeparators = pattern[1] == '*';
+        while (*pattern == '*')
+          ++pattern;
+        for (;; ++text)
+        {
+          if (MatchGlob(pattern, text))
+            return true;
+          if (*text == '\0' || (*text == '/' && !crossSeparators))
+            return false;
+        }
+      }
+
+      if (*text == '\0' || (*pattern == '?' ? *text == '/' : *pattern != *text))
+        return false;
+    }
+    return *text == '\0';
+  }
+
+  //------------------------------------------------------------------------------------------------
+  bool IsDirectory(const std::string& path)
+  {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+  }
+
+  //------------------------------------------------------------------------------------------------
+  std::string JoinPath(const std::string& directory, const std::string& name)
+  {
+    if (directory.empty())
+      return name;
+    if (directory.back() == '/' || directory.back() == '\\')
+      return directory + name;
+    return directory + '/' + name;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+InputList::InputList() :
+  includes_({ "*.h", "*.hh", "*.hpp", "*.hxx" })
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::Add(const std::string& argument)
+{
+  error_.clear();
+  return AddArgument(argument, 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::AddArgument(const std::string& argument, int depth)
+{
+  if (argument.size() > 1 && argument[0] == '@')
+    return AddResponseFile(argument.substr(1), depth + 1);
+
+  if (IsDirectory(argument))
+    return AddDirectory(argument);
+
+  // Anything else is opened as a file when it is processed
+  AddFile(argument);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::AddResponseFile(const std::string& path, int depth)
+{
+  if (depth > kMaxResponseFileDepth)
+  {
+    error_ = "Response files nested too deeply at " + path;
+    return false;
+  }
+
+  InputFile file;
+  if (!file.Open(path))
+  {
+    error_ = "Could not open response file " + path;
+    return false;
+  }
+
+  const char* data = file.data();
+  const char* end = data + file.size();
+  while (data != end)
+  {
+    const char* lineEnd = std::find(data, end, '\n');
+
+    // Trim white space, including the carriage return of CRLF line endings
+    const char* first = data;
+    const char* last = lineEnd;
+    while (first != last && (*first == ' ' || *first == '\t' || *first == '\r'))
+      ++first;
+    while (last != first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+      --last;
+
+    // Paths with spaces may be quoted
+    if (last - first >= 2 && *first == '"' && last[-1] == '"')
+    {
+      ++first;
+      --last;
+    }
+
+    if (first != last && *first != '#' && !AddArgument(std::string(first, last), depth))
+      return false;
+
+    data = lineEnd == end ? end : lineEnd + 1;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::AddDirectory(const std::string& path)
+{
+  std::vector<std::string> found;
+  if (!Walk(path, std::string(), found))
+    return false;
+
+  for (const std::string& file : found)
+    AddFile(file);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::Walk(const std::string& path, const std::string& relative, std::vector<std::string>& result)
+{
+  // The directories still to list are shared by the threads, relative to the walked directory. A
+  // thread is busy while it lists a directory and may still add subdirectories, the walk is complete
+  // when nothing is left to list and no thread is busy.
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<std::string> pending(1, relative);
+  unsigned busy = 0;
+  std::vector<std::string> found;
+  std::vector<std::string> walked;
+  std::string failed;
+
+  auto walk = [&]()
+  {
+    std::vector<std::string> files;
+    std::vector<std::string> directories;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+      changed.wait(lock, [&]() { return !pending.empty() || busy == 0; });
+      if (pending.empty())
+        break;
+
+      std::string directory = std::move(pending.back());
+      pending.pop_back();
+      ++busy;
+      lock.unlock();
+
+      files.clear();
+      directories.clear();
+      const bool listed = ListDirectory(path, directory, files, directories);
+
+      lock.lock();
+      --busy;
+      if (!listed && failed.empty())
+        failed = JoinPath(path, directory);
+      if (listed)
+        walked.push_back(std::move(directory));
+      found.insert(found.end(), files.begin(), files.end());
+      pending.insert(pending.end(), directories.begin(), directories.end());
+      changed.notify_all();
+    }
+  };
+
+  const unsigned threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxWalkThreads));
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(walk);
+  walk();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  if (!failed.empty())
+  {
+    error_ = "Could not read directory " + failed;
+    return false;
+  }
+
+  // The order in which the threads find the files varies, sort them so the output does not
+  std::sort(found.begin(), found.end());
+  result.clear();
+  for (const std::string& file : found)
+    result.push_back(JoinPath(path, file));
+
+  std::sort(walked.begin(), walked.end());
+  for (std::string& directory : walked)
+    directories_.push_back({ path, std::move(directory) });
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void InputList::AddFile(const std::string& path)
+{
+  if (added_.insert(path).second)
+    files_.push_back(path);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::ListDirectory(const std::string& root, const std::string& directory,
+  std::vector<std::string>& files, std::vector<std::string>& directories) const
+{
+  const std::string path = JoinPath(root, directory);
+
+  // Lists the entry with the given name, the path relative to the root is built in relative
+  std::string relative;
+  auto addEntry = [&](const char* name, bool isDirectory)
+  {
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+      return;
+
+    relative = JoinPath(directory, name);
+    if (!Accepts(relative, isDirectory))
+      return;
+
+    if (isDirectory)
+      directories.push_back(relative);
+    else
+      files.push_back(relative);
+  };
+
+#ifdef _WIN32
+  WIN32_FIND_DATAA entry;
+  HANDLE find = FindFirstFileA(JoinPath(path, "*").c_str(), &entry);
+  if (find == INVALID_HANDLE_VALUE)
+    return false;
+
+  do
+  {
+    const bool isDirectory = (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    if (isDirectory && (entry.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+      continue;
+    addEntry(entry.cFileName, isDirectory);
+  } while (FindNextFileA(find, &entry));
+  FindClose(find);
+#else
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr)
+    return false;
+
+  while (struct dirent* entry = readdir(dir))
+  {
+    // Symbolic links are followed to files only, so walking cannot loop
+    bool isDirectory = false;
+#ifdef DT_DIR
+    if (entry->d_type == DT_DIR)
+      isDirectory = true;
+    else if (entry->d_type == DT_REG)
+      isDirectory = false;
+    else
+#endif
+    {
+      struct stat st;
+      const std::string entryPath = JoinPath(path, entry->d_name);
+      if (lstat(entryPath.c_str(), &st) != 0)
+        continue;
+      const bool isLink = S_ISLNK(st.st_mode);
+      if (isLink && stat(entryPath.c_str(), &st) != 0)
+        continue;
+      isDirectory = S_ISDIR(st.st_mode);
+      if (isDirectory ? isLink : !S_ISREG(st.st_mode))
+        continue;
+    }
+    addEntry(entry->d_name, isDirectory);
+  }
+  closedir(dir);
+#endif
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::Accepts(const std::string& relative, bool isDirectory) const
+{
+  const std::size_t nameStart = relative.rfind('/') + 1;
+  if (Matches(excludes_, relative, nameStart))
+    return false;
+  return isDirectory || Matches(includes_, relative, nameStart);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool InputList::Matches(const std::vector<std::string>& patterns, const std::string& path, std::size_t nameStart)
+{
+  for (const std::string& pattern : patterns)
+  {
+    const bool matchPath = pattern.find('/') != std::string::npos;
+    if (MatchGlob(pattern.c_str(), path.c_str() + (matchPath ? 0 : nameStart)))
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Collects the headers to process from the arguments on the command line.
+ * @details An argument is a file, a directory or a response file. A response file is named by an
+ * argument that starts with '@' and holds one argument per line; empty lines and lines that start with
+ * '#' are ignored. Directories are walked recursively by several threads at once. The files found in
+ * directories have to match one of the include patterns and must not match an exclude pattern, files
+ * that are named explicitly are always processed. Directories that match an exclude pattern are not
+ * walked, and symbolic links to directories are not followed.
+ *
+ * Patterns are globs in which '*' matches any text except '/', "**" any text and '?' any character but
+ * '/'. A pattern without a '/' is matched against the name of a file or directory, a pattern with a '/'
+ * against its path relative to the directory that is walked.
+ */
+class InputList
+{
+public:
+  /// A directory that was walked, given by the directory argument and the path relative to it
+  struct Directory
+  {
+    std::string root;
+    std::string relative;
+  };
+
+  InputList();
+
+  // Do not allow copy or move
+  InputList(const InputList& other) = delete;
+  InputList(InputList&& other) = delete;
+
+  /// Sets the patterns of the files to process in directories, by default common header extensions
+  void SetIncludes(const std::vector<std::string>& patterns) { includes_ = patterns; }
+
+  /// Sets the patterns of the files and directories to skip in directories
+  void SetExcludes(const std::vector<std::string>& patterns) { excludes_ = patterns; }
+
+  /// Adds the files of a file, directory or response file argument. Returns false if a directory or
+  /// response file cannot be read.
+  bool Add(const std::string& argument);
+
+  /// Returns the files to process in the order of the arguments, the files found in a directory are
+  /// sorted by path. Every file is listed once.
+  const std::vector<std::string>& files() const { return files_; }
+
+  /// Returns the directories that were walked, sorted by path for every directory argument
+  const std::vector<Directory>& directories() const { return directories_; }
+
+  /// Returns the reason the last call to Add or Walk failed
+  const std::string& error() const { return error_; }
+
+  /// Returns true if a file or directory with the given path relative to a walked directory argument
+  /// passes the filters
+  bool Accepts(const std::string& relative, bool isDirectory) const;
+
+  /**
+   * @brief Walks the directory at the relative path below the directory argument at path, for example
+   * one that was created since.
+   * @details The files that pass the filters are returned in files, sorted by path, and the directories
+   * that were walked are added to directories(). files() is left as it is.
+   */
+  bool Walk(const std::string& path, const std::string& relative, std::vector<std::string>& files);
+
+private:
+  bool AddArgument(const std::string& argument, int depth);
+  bool AddResponseFile(const std::string& path, int depth);
+  bool AddDirectory(const std::string& path);
+  void AddFile(const std::string& path);
+
+  /// Lists the given directory relative to the walked root. Adds the files that pass the filters to
+  /// files and the directories to walk to directories.
+  bool ListDirectory(const std::string& root, const std::string& directory,
+    std::vector<std::string>& files, std::vector<std::string>& directories) const;
+
+  /// Returns true if the file or directory with the given path relative to the root matches one of the
+  /// given patterns
+  static bool Matches(const std::vector<std::string>& patterns, const std::string& path, std::size_t nameStart);
+
+private:
+  std::vector<std::string> includes_;
+  std::vector<std::string> excludes_;
+
+  std::vector<std::string> files_;
+  std::unordered_set<std::string> added_;
+  std::vector<Directory> directories_;
+
+  std::string error_;
+};
@@ -0,0 +1,656 @@
+#include "json_handler.h"
+
+//-------------------------------------------------------------------------------------------------
+// Class used to write a typenode structure to json
+//-------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+class TypeNodeWriter : public TypeNodeVisitor<TypeNodeWriter<JsonWriter>>
+{
+public:
+  /// If childrenById is set the children of the visited node are written as their index in the tree
+  TypeNodeWriter(const TypeTree& tree, JsonWriter& writer, bool childrenById = false) :
+    TypeNodeVisitor<TypeNodeWriter>(tree),
+    writer_(writer),
+    childrenById_(childrenById),
+    depth_(0) {}
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitFunction(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("function");
+
+    writer_.String("returnType");
+    VisitNode(node.function.returns);
+
+    writer_.String("arguments");
+    writer_.StartArray();
+    for (uint32_t i = 0; i < node.function.arguments.count; ++i)
+    {
+      const TypeArgument& arg = this->tree().argument(node.function.arguments.first + i);
+      writer_.StartObject();
+      if (arg.name.count != 0)
+      {
+        writer_.String("name");
+        WriteString(this->tree().text(arg.name));
+      }
+      writer_.String("type");
+      VisitNode(arg.type);
+      writer_.EndObject();
+    }
+    writer_.EndArray();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitLReference(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("lreference");
+
+    writer_.String("baseType");
+    VisitNode(node.base);
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitLiteral(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("literal");
+
+    writer_.String("name");
+    WriteString(this->tree().text(node.named.name));
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitPointer(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("pointer");
+
+    writer_.String("baseType");
+    VisitNode(node.base);
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitReference(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("reference");
+
+    writer_.String("baseType");
+    VisitNode(node.base);
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitTemplate(const TypeNode& node)
+  {
+    writer_.String("type");
+    writer_.String("template");
+
+    writer_.String("name");
+    WriteString(this->tree().text(node.named.name));
+
+    writer_.String("arguments");
+    writer_.StartArray();
+    for (uint32_t i = 0; i < node.named.arguments.count; ++i)
+      VisitNode(this->tree().argument(node.named.arguments.first + i).type);
+    writer_.EndArray();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+  void VisitNode(uint32_t index)
+  {
+    if (childrenById_ && depth_ != 0)
+    {
+      writer_.Uint(index);
+      return;
+    }
+
+    const TypeNode& node = this->tree().node(index);
+    ++depth_;
+    writer_.StartObject();
+    if (node.isConst)
+    {
+      writer_.String("const");
+      writer_.Bool(true);
+    }
+    if (node.isMutable)
+    {
+      writer_.String("mutable");
+      writer_.Bool(true);
+    }
+    if (node.isVolatile)
+    {
+      writer_.String("volatile");
+      writer_.Bool(true);
+    }
+    TypeNodeVisitor<TypeNodeWriter>::VisitNode(index);
+    writer_.EndObject();
+    --depth_;
+  }
+
+private:
+  //-------------------------------------------------------------------------------------------------
+  void WriteString(const StringView& str)
+  {
+    writer_.String(str.data, static_cast<rapidjson::SizeType>(str.length));
+  }
+
+  JsonWriter &writer_;
+  bool childrenById_;
+  uint32_t depth_;
+};
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+JsonHandler<JsonWriter>::JsonHandler(const Options& options) :
+  typeTable_(options.typeTable),
+  writer_(output_)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Reset()
+{
+  output_.Clear();
+  writer_.Reset(output_);
+  types_.Clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::StartDocument()
+{
+  // Start the array, in an object next to the types table if there is one
+  if (typeTable_)
+  {
+    writer_.StartObject();
+    writer_.String("declarations");
+  }
+  writer_.StartArray();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::EndDocument()
+{
+  writer_.EndArray();
+  if (typeTable_)
+  {
+    WriteTypeTable();
+    writer_.EndObject();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Include(const IncludeInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("include");
+  writer_.String("file");
+  WriteString(info.file);
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::StartNamespace(const NamespaceInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("namespace");
+  writer_.String("name");
+  WriteString(info.name);
+  writer_.String("members");
+  writer_.StartArray();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::EndNamespace()
+{
+  writer_.EndArray();
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::StartClass(const ClassInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("class");
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteAccess(info);
+  WriteComment(info);
+  WriteMeta(info);
+
+  if (info.isTemplate)
+  {
+    writer_.String("template");
+    writer_.StartObject();
+    writer_.String("arguments");
+    writer_.StartArray();
+    for (const TemplateArgumentInfo& argument : info.templateArguments)
+    {
+      writer_.StartObject();
+      writer_.String("typeParameterKey");
+      WriteString(argument.typeParameterKey);
+      writer_.String("name");
+      WriteString(argument.name);
+      if (argument.defaultType != kNoTypeNode)
+      {
+        writer_.String("defaultType");
+        WriteType(info, argument.defaultType);
+      }
+      writer_.EndObject();
+    }
+    writer_.EndArray();
+    writer_.EndObject();
+  }
+
+  writer_.String("isstruct");
+  writer_.Bool(info.isStruct);
+
+  writer_.String("name");
+  WriteString(info.name);
+
+  if (!info.parents.empty())
+  {
+    writer_.String("parents");
+    writer_.StartArray();
+    for (const ParentInfo& parent : info.parents)
+    {
+      writer_.StartObject();
+      WriteAccessControlType(parent.access);
+      writer_.String("name");
+      WriteType(info, parent.type);
+      writer_.EndObject();
+    }
+    writer_.EndArray();
+  }
+
+  writer_.String("members");
+  writer_.StartArray();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::EndClass()
+{
+  writer_.EndArray();
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Enum(const EnumInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("enum");
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteAccess(info);
+  WriteMeta(info);
+
+  writer_.String("name");
+  WriteString(info.name);
+
+  if (info.isEnumClass)
+  {
+    writer_.String("cxxclass");
+    writer_.Bool(true);
+  }
+
+  if (!info.base.empty())
+  {
+    writer_.String("base");
+    WriteString(info.base);
+  }
+
+  writer_.String("members");
+  writer_.StartArray();
+  for (const EnumeratorInfo& member : info.members)
+  {
+    writer_.StartObject();
+    writer_.String("key");
+    WriteString(member.key);
+    if (member.hasValue)
+    {
+      writer_.String("value");
+      WriteString(member.value);
+    }
+    writer_.EndObject();
+  }
+  writer_.EndArray();
+
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Property(const PropertyInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("property");
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteMeta(info);
+  WriteAccess(info);
+
+  if (info.isMutable)
+  {
+    writer_.String("mutable");
+    writer_.Bool(true);
+  }
+  if (info.isStatic)
+  {
+    writer_.String("static");
+    writer_.Bool(true);
+  }
+
+  writer_.String("dataType");
+  WriteType(info, info.dataType);
+
+  writer_.String("name");
+  WriteString(info.name);
+
+  writer_.String("elements");
+  if (info.isArray)
+    WriteString(info.elements);
+  else
+    writer_.Null();
+
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Function(const FunctionInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("function");
+  writer_.String("macro");
+  WriteString(info.macro);
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteComment(info);
+  WriteMeta(info);
+  WriteAccess(info);
+
+  // Write method specifiers
+  if (info.isVirtual)
+  {
+    writer_.String("virtual");
+    writer_.Bool(true);
+  }
+  if (info.isInline)
+  {
+    writer_.String("inline");
+    writer_.Bool(true);
+  }
+  if (info.isConstExpr)
+  {
+    writer_.String("constexpr");
+    writer_.Bool(true);
+  }
+  if (info.isStatic)
+  {
+    writer_.String("static");
+    writer_.Bool(true);
+  }
+
+  writer_.String("returnType");
+  WriteType(info, info.returnType);
+
+  writer_.String("name");
+  WriteString(info.name);
+
+  WriteArguments(info, info.arguments);
+
+  if (info.isConst)
+  {
+    writer_.String("const");
+    writer_.Bool(true);
+  }
+  if (info.isAbstract)
+  {
+    writer_.String("abstract");
+    writer_.Bool(true);
+  }
+
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Constructor(const ConstructorInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("constructor");
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteComment(info);
+  WriteMeta(info);
+  WriteAccess(info);
+
+  if (info.isInline)
+  {
+    writer_.String("inline");
+    writer_.Bool(true);
+  }
+
+  writer_.String("name");
+  WriteString(info.name);
+
+  WriteArguments(info, info.arguments);
+
+  if (info.isDefault)
+  {
+    writer_.String("default");
+    writer_.Bool(true);
+  }
+
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::Macro(const MacroInfo& info)
+{
+  writer_.StartObject();
+  writer_.String("type");
+  writer_.String("macro");
+  writer_.String("name");
+  WriteString(info.name);
+  writer_.String("line");
+  writer_.Uint((unsigned)info.line);
+
+  WriteAccess(info);
+  WriteMeta(info);
+
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteAccess(const DeclarationInfo& info)
+{
+  // Writing access is not required if the declaration is not owned by a class
+  if (info.isMember)
+    WriteAccessControlType(info.access);
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteAccessControlType(AccessControlType type)
+{
+  writer_.String("access");
+  switch (type)
+  {
+  case AccessControlType::kPublic:
+    writer_.String("public");
+    break;
+  case AccessControlType::kProtected:
+    writer_.String("protected");
+    break;
+  case AccessControlType::kPrivate:
+    writer_.String("private");
+    break;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteComment(const DeclarationInfo& info)
+{
+  if (!info.comment.empty())
+  {
+    writer_.String("comment");
+    WriteString(info.comment);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteMeta(const DeclarationInfo& info)
+{
+  writer_.String("meta");
+  WriteMetaSequence(info.meta, info.meta + info.metaCount);
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteMetaSequence(const MetaEntry* first, const MetaEntry* last)
+{
+  writer_.StartObject();
+  for (const MetaEntry* entry = first; entry != last; ++entry)
+  {
+    WriteString(entry->key);
+    switch (entry->type)
+    {
+    case MetaEntry::Type::kNull:
+      writer_.Null();
+      break;
+    case MetaEntry::Type::kValue:
+      WriteToken(entry->value);
+      break;
+    case MetaEntry::Type::kSequence:
+      WriteMetaSequence(entry + 1, entry + 1 + entry->count);
+      entry += entry->count;
+      break;
+    }
+  }
+  writer_.EndObject();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteArguments(const DeclarationInfo& info, const std::vector<ArgumentInfo>& arguments)
+{
+  writer_.String("arguments");
+  writer_.StartArray();
+  for (const ArgumentInfo& argument : arguments)
+  {
+    writer_.StartObject();
+    writer_.String("type");
+    WriteType(info, argument.type);
+    writer_.String("name");
+    WriteString(argument.name);
+    if (argument.hasDefaultValue)
+    {
+      writer_.String("defaultValue");
+      WriteToken(argument.defaultValue);
+    }
+    writer_.EndObject();
+  }
+  writer_.EndArray();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteType(const DeclarationInfo& info, uint32_t type)
+{
+  // Refer to the type table instead of writing the type in place
+  if (typeTable_)
+  {
+    writer_.Uint(types_.Intern(*info.types, type));
+    return;
+  }
+
+  TypeNodeWriter<JsonWriter> writer(*info.types, writer_);
+  writer.VisitNode(type);
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteTypeTable()
+{
+  writer_.String("types");
+  writer_.StartArray();
+  TypeNodeWriter<JsonWriter> writer(types_.types(), writer_, true);
+  for (uint32_t id = 0; id < types_.size(); ++id)
+    writer.VisitNode(id);
+  writer_.EndArray();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteToken(const Token& token)
+{
+  if (token.tokenType == TokenType::kConst)
+  {
+    switch (token.constType)
+    {
+    case ConstType::kBoolean:
+      writer_.Bool(token.boolConst);
+      break;
+    case ConstType::kUInt32:
+      writer_.Uint(token.uint32Const);
+      break;
+    case ConstType::kInt32:
+      writer_.Int(token.int32Const);
+      break;
+    case ConstType::kUInt64:
+      writer_.Uint64(token.uint64Const);
+      break;
+    case ConstType::kInt64:
+      writer_.Int64(token.int64Const);
+      break;
+    case ConstType::kReal:
+      writer_.Double(token.realConst);
+      break;
+    case ConstType::kString:
+      WriteString(token.token);
+      break;
+    }
+  }
+  else
+    WriteString(token.token);
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename JsonWriter>
+void JsonHandler<JsonWriter>::WriteString(const StringView& str)
+{
+  writer_.String(str.data, static_cast<rapidjson::SizeType>(str.length));
+}
+
+//--------------------------------------------------------------------------------------------------
+// The writers that can be selected on the command line
+template class JsonHandler<rapidjson::PrettyWriter<OutputStream>>;
+template class JsonHandler<rapidjson::Writer<OutputStream>>;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "handler.h"
+#include "options.h"
+#include "output_stream.h"
+#include "type_table.h"
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/writer.h>
+
+/**
+ * @brief Handler that writes the declarations as json.
+ * @details The handler is a template over the rapidjson writer and is not derived from Handler, so a
+ * parser that is instantiated for it resolves all calls at compile time. It is instantiated for the
+ * writers in json_handler.cc.
+ */
+template<typename JsonWriter>
+class JsonHandler
+{
+public:
+  JsonHandler(const Options& options);
+
+  // Do not allow copy or move
+  JsonHandler(const JsonHandler& other) = delete;
+  JsonHandler(JsonHandler&& other) = delete;
+
+  /// Discards the output and the type table of a previous document
+  void Reset();
+
+  /// Writes the start and the end of the document around the declarations
+  void StartDocument();
+  void EndDocument();
+
+  /// The stream the document is written to
+  OutputStream& output() { return output_; }
+  const OutputStream& output() const { return output_; }
+
+  // See Handler
+  void Include(const IncludeInfo& info);
+  void StartNamespace(const NamespaceInfo& info);
+  void EndNamespace();
+  void StartClass(const ClassInfo& info);
+  void EndClass();
+  void Enum(const EnumInfo& info);
+  void Property(const PropertyInfo& info);
+  void Function(const FunctionInfo& info);
+  void Constructor(const ConstructorInfo& info);
+  void Macro(const MacroInfo& info);
+
+private:
+  void WriteAccess(const DeclarationInfo& info);
+  void WriteAccessControlType(AccessControlType type);
+  void WriteComment(const DeclarationInfo& info);
+  void WriteMeta(const DeclarationInfo& info);
+  void WriteMetaSequence(const MetaEntry* first, const MetaEntry* last);
+  void WriteArguments(const DeclarationInfo& info, const std::vector<ArgumentInfo>& arguments);
+  void WriteType(const DeclarationInfo& info, uint32_t type);
+  void WriteTypeTable();
+  void WriteToken(const Token& token);
+  void WriteString(const StringView& str);
+
+private:
+  /// Write every distinct type once to the table and refer to it by index
+  bool typeTable_;
+  TypeTable types_;
+
+  OutputStream output_;
+  JsonWriter writer_;
+};
@@ -1,22 +1,626 @@
 #include "parser.h"
 #include "handler.h"
 #include "options.h"
+#include "file_loader.h"
+#include "file_watcher.h"
+#include "input_file.h"
+#include "input_list.h"
+#include "result_cache.h"
+#include "task_scheduler.h"
 #include <tclap/CmdLine.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 //----------------------------------------------------------------------------------------------------
 void print_usage()
 {
-  std::cout << "Usage: inputFile" << std::endl;
+  std::cout << "Usage: inputFiles" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Writes the given text to output as a json string
+void write_json_string(OutputStream& output, const std::string& text)
+{
+  static const char kHexDigits[] = "0123456789abcdef";
+
+  output.Put('"');
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+      output.Put('\\');
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      for (char escaped : { '\\', 'u', '0', '0', kHexDigits[c >> 4], kHexDigits[c & 0xf] })
+        output.Put(escaped);
+      continue;
+    }
+    output.Put(c);
+  }
+  output.Put('"');
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Returns the path of the output of the given input in the output directory. The input path is made
+/// relative by dropping the root and all "." and ".." components, so the output stays in the directory.
+std::string mirrored_path(const std::string& directory, const std::string& input, const char* extension)
+{
+  std::string path = directory;
+  std::size_t start = 0;
+  while (start < input.size())
+  {
+    std::size_t end = input.find_first_of("/\\", start);
+    if (end == std::string::npos)
+      end = input.size();
+
+    const std::string component = input.substr(start, end - start);
+    if (!component.empty() && component != "." && component != ".." && component.back() != ':')
+    {
+      if (!path.empty() && path.back() != '/')
+        path += '/';
+      path += component;
+    }
+    start = end + 1;
+  }
+  return path + extension;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Creates the directories that contain the file at the given path
+bool make_parent_directories(const std::string& path)
+{
+  for (std::size_t end = path.find('/', 1); end != std::string::npos; end = path.find('/', end + 1))
+  {
+    const std::string directory = path.substr(0, end);
+#ifdef _WIN32
+    if (_mkdir(directory.c_str()) != 0 && errno != EEXIST)
+#else
+    if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST)
+#endif
+      return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Creates or truncates the output file at the given path and the directories that contain it.
+/// Returns its file descriptor, or -1 if it cannot be created.
+int create_output_file(const std::string& path)
+{
+  if (!make_parent_directories(path))
+    return -1;
+#ifdef _WIN32
+  return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Returns true if there is a file at the given path
+bool file_exists(const std::string& path)
+{
+#ifdef _WIN32
+  struct _stat64 st;
+  return _stat64(path.c_str(), &st) == 0 && (st.st_mode & _S_IFDIR) == 0;
+#else
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Returns the size of the file at the given path, or 0 if it cannot be determined
+uint64_t file_size(const std::string& path)
+{
+#ifdef _WIN32
+  struct _stat64 st;
+  return _stat64(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#else
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Parses the input and appends its output to output. With a cache the output of an input that was
+/// parsed before is taken from the cache, and the output of other inputs is stored in it.
+template<typename ParserType>
+bool parse_cached(ParserType& parser, ResultCache* cache, const InputFile& input, std::string& output)
+{
+  if (cache != nullptr && cache->Load(input.data(), input.size(), output))
+    return true;
+
+  if (!parser.Parse(input.data(), input.size(), output))
+    return false;
+
+  if (cache != nullptr)
+    cache->Store(input.data(), input.size(), output);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Parses the input and writes its output to stdout. Parse errors are written to stderr, prefixed with
+/// the given path, after the output up to the error.
+template<typename ParserType>
+bool parse_to_stdout(const Options& options, const std::string& path, const InputFile& input, ResultCache* cache)
+{
+  ParserType parser(options);
+  std::string output;
+  if (cache != nullptr && parse_cached(parser, cache, input, output))
+  {
+    OutputStream stream;
+    stream.Open(kStandardOutput);
+    stream.Write(output.data(), output.size());
+    stream.Flush();
+    if (stream.failed())
+    {
+      std::cerr << "Could not write the output" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // The output up to an error is written as well, parse again to write it
+  if (parser.Parse(input.data(), input.size(), kStandardOutput))
+    return true;
+
+  if (*parser.error() != '\0')
+    std::cerr << path << ":" << parser.error() << std::endl;
+  else
+    std::cerr << "Could not write the output" << std::endl;
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// The outcome of parsing one of several files
+struct FileResult
+{
+  bool done = false;
+  bool succeeded = false;
+
+  /// The output of the file if it is collected in memory
+  std::string output;
+
+  /// The reason parsing the file failed
+  std::string error;
+};
+
+//----------------------------------------------------------------------------------------------------
+/**
+ * @brief Parses the files on the given number of threads, with a parser per thread.
+ * @details parse(parser, input, path, result) is called on the threads and fills in the result of a
+ * file. write(path, result) is called on the calling thread with the result of every file that was
+ * parsed, in the order of the files; failures are reported in that order as well. The output therefore
+ * does not depend on the number of threads. The largest files are parsed first, see TaskScheduler.
+ */
+template<typename ParserType, typename ParseFunction, typename WriteFunction>
+bool parse_files(const Options& options, const std::vector<std::string>& files, unsigned jobs, ParseFunction parse, WriteFunction write)
+{
+  std::vector<uint64_t> costs;
+  costs.reserve(files.size());
+  for (const std::string& path : files)
+    costs.push_back(file_size(path));
+
+  const unsigned threadCount = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(jobs, files.size())));
+  std::vector<std::unique_ptr<ParserType>> parsers;
+  std::vector<std::unique_ptr<InputFile>> inputs;
+  for (unsigned i = 0; i < threadCount; ++i)
+  {
+    parsers.emplace_back(new ParserType(options));
+    inputs.emplace_back(new InputFile);
+  }
+
+  // Read the files ahead of the workers, so they rarely wait for the disk
+  static const std::size_t kReadAheadSize = 64 * 1024 * 1024;
+  FileLoader loader(files, costs, kReadAheadSize);
+  std::vector<std::vector<char>> buffers(threadCount);
+
+  std::vector<FileResult> results(files.size());
+  std::mutex mutex;
+  std::condition_variable parsed;
+  TaskScheduler scheduler(threadCount, costs, [&](unsigned worker, std::size_t index)
+  {
+    FileResult& result = results[index];
+    InputFile& input = *inputs[worker];
+    std::vector<char>& buffer = buffers[worker];
+    const bool loaded = loader.Take(index, buffer);
+    if (loaded)
+      input.Open(buffer);
+    if (!loaded && !input.Open(files[index]))
+      result.error = "Could not open " + files[index];
+    else
+      result.succeeded = parse(*parsers[worker], input, files[index], result);
+    input.Close();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    result.done = true;
+    parsed.notify_all();
+  });
+
+  bool succeeded = true;
+  for (std::size_t i = 0; i < files.size(); ++i)
+  {
+    FileResult& result = results[i];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      parsed.wait(lock, [&result]() { return result.done; });
+    }
+
+    if (result.succeeded)
+      write(files[i], result);
+    else
+    {
+      std::cerr << result.error << std::endl;
+      succeeded = false;
+    }
+    std::string().swap(result.output);
+  }
+  return succeeded;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Writes a single json object to stdout that maps the path of every file to its declarations. Files
+/// that cannot be parsed are reported and left out.
+template<typename ParserType>
+bool parse_to_document(const Options& options, const std::vector<std::string>& files, unsigned jobs, ResultCache* cache)
+{
+  // The declarations of every file are written indented by one level
+  const char* newline = options.compact ? "" : "\n    ";
+  const char* separator = options.compact ? ":" : ": ";
+
+  OutputStream output;
+  output.Open(kStandardOutput);
+  bool empty = true;
+  output.Put('{');
+
+  auto parse = [cache](ParserType& parser, const InputFile& input, const std::string& path, FileResult& result)
+  {
+    if (parse_cached(parser, cache, input, result.output))
+      return true;
+    result.error = path + ":" + parser.error();
+    return false;
+  };
+
+  auto write = [&](const std::string& path, const FileResult& result)
+  {
+    if (!empty)
+      output.Put(',');
+    empty = false;
+    for (const char* c = newline; *c != '\0'; ++c)
+      output.Put(*c);
+    write_json_string(output, path);
+    for (const char* c = separator; *c != '\0'; ++c)
+      output.Put(*c);
+
+    // Pretty json only has new lines between values, strings escape them
+    for (char c : result.output)
+    {
+      if (c == '\n')
+      {
+        for (const char* n = newline; *n != '\0'; ++n)
+          output.Put(*n);
+      }
+      else
+        output.Put(c);
+    }
+  };
+
+  const bool succeeded = parse_files<ParserType>(options, files, jobs, parse, write);
+  if (!empty && !options.compact)
+    output.Put('\n');
+  output.Put('}');
+  output.Put('\n');
+  output.Flush();
+
+  if (output.failed())
+  {
+    std::cerr << "Could not write the output" << std::endl;
+    return false;
+  }
+  return succeeded;
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Writes the output of every file to a file of the same relative path in the given directory
+template<typename ParserType>
+bool parse_to_directory(const Options& options, const std::vector<std::string>& files, const std::string& directory, unsigned jobs, ResultCache* cache)
+{
+  const char* extension = options.binary ? ".bin" : ".json";
+
+  auto parse = [&](ParserType& parser, const InputFile& input, const std::string& path, FileResult& result)
+  {
+    const std::string outputPath = mirrored_path(directory, path, extension);
+    const int fd = create_output_file(outputPath);
+    if (fd < 0)
+    {
+      result.error = "Could not create " + outputPath;
+      return false;
+    }
+
+    // With a cache the output is collected in memory to store it, or taken from the cache
+    bool parsed;
+    bool written = true;
+    if (cache == nullptr)
+      parsed = written = parser.Parse(input.data(), input.size(), fd);
+    else
+    {
+      std::string output;
+      parsed = parse_cached(parser, cache, input, output);
+      if (parsed)
+      {
+        OutputStream stream;
+        stream.Open(fd);
+        stream.Write(output.data(), output.size());
+        stream.Flush();
+        written = !stream.failed();
+      }
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    if (parsed && written)
+      return true;
+
+    // Do not leave incomplete output behind
+    if (!parsed && *parser.error() != '\0')
+      result.error = path + ":" + parser.error();
+    else
+      result.error = "Could not write " + outputPath;
+    std::remove(outputPath.c_str());
+    return false;
+  };
+
+  return parse_files<ParserType>(options, files, jobs, parse, [](const std::string&, const FileResult&) {});
+}
+
+//----------------------------------------------------------------------------------------------------
+/// Returns the path of name in directory, an empty directory is the working directory
+std::string join_path(const std::string& directory, const std::string& name)
+{
+  if (directory.empty())
+    return name;
+  if (directory.back() == '/' || directory.back() == '\\')
+    return directory + name;
+  return directory + '/' + name;
+}
+
+//----------------------------------------------------------------------------------------------------
+/**
+ * @brief Writes the output of every file to the output directory and keeps it up to date.
+ * @details The directories that contain the files are watched, and files that change are parsed again
+ * while the output of all files is kept in memory. An output file is only rewritten if its output
+ * changed, so tools that watch the output directory are not triggered needlessly. Files that are added
+ * to a walked directory are parsed as well, and the output of files that are removed is deleted.
+ * Returns false if the files cannot be watched, otherwise it runs until the process is stopped.
+ */
+template<typename ParserType>
+bool watch_directory(const Options& options, InputList& inputs, const std::string& directory, unsigned jobs, ResultCache* cache)
+{
+  const char* extension = options.binary ? ".bin" : ".json";
+
+  FileWatcher watcher;
+  if (!watcher.Open())
+  {
+    std::cerr << "Watching files is not supported on this platform" << std::endl;
+    return false;
+  }
+
+  // The files by the path of the change that reports them, which is the path of the file unless the
+  // file was named with redundant separators
+  std::unordered_map<std::string, std::string> known;
+
+  // The walked directories by path, to filter the files that are added to them
+  std::unordered_map<std::string, InputList::Directory> walked;
+  std::size_t watchedCount = 0;
+
+  // The directories of files that were named explicitly
+  std::unordered_set<std::string> parents;
+
+  auto watch_file = [&](const std::string& path)
+  {
+    const std::size_t separator = path.find_last_of("/\\");
+    const std::string parent = separator == std::string::npos ? std::string() : path.substr(0, separator);
+    const std::string name = separator == std::string::npos ? path : path.substr(separator + 1);
+    if (known.emplace(join_path(parent, name), path).second && !walked.count(parent) && parents.insert(parent).second)
+      watcher.Watch(parent);
+  };
+
+  // Watches the directories walked since the last call, these report their files by the walked path
+  auto watch_directories = [&]()
+  {
+    for (; watchedCount < inputs.directories().size(); ++watchedCount)
+    {
+      const InputList::Directory& walkedDirectory = inputs.directories()[watchedCount];
+      std::string path = join_path(walkedDirectory.root, walkedDirectory.relative);
+      if (path.size() > 1 && (path.back() == '/' || path.back() == '\\'))
+        path.pop_back();
+      walked[path] = walkedDirectory;
+      if (!watcher.Watch(path))
+        std::cerr << "Could not watch " << path << std::endl;
+    }
+  };
+
+  // Start watching before the first parse, so no change is missed
+  watch_directories();
+  for (const std::string& path : inputs.files())
+    watch_file(path);
+
+  // The output of every file that was parsed, written by the thread that parses the file
+  std::unordered_map<std::string, std::string> outputs;
+  auto parse = [&](ParserType& parser, const InputFile& input, const std::string& path, FileResult& result)
+  {
+    std::string& previous = outputs.find(path)->second;
+    const std::string outputPath = mirrored_path(directory, path, extension);
+    if (!parse_cached(parser, cache, input, result.output))
+    {
+      // Do not leave the output of an earlier version behind
+      result.error = path + ":" + parser.error();
+      std::remove(outputPath.c_str());
+      previous.clear();
+      return false;
+    }
+
+    if (result.output == previous)
+      return true;
+
+    const int fd = create_output_file(outputPath);
+    if (fd < 0)
+    {
+      result.error = "Could not create " + outputPath;
+      return false;
+    }
+
+    OutputStream stream;
+    stream.Open(fd);
+    stream.Write(result.output.data(), result.output.size());
+    stream.Flush();
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+    if (stream.failed())
+    {
+      result.error = "Could not write " + outputPath;
+      std::remove(outputPath.c_str());
+      previous.clear();
+      return false;
+    }
+
+    previous.swap(result.output);
+    return true;
+  };
+
+  // Parses the files that still exist and removes the output of the others
+  auto update = [&](const std::set<std::string>& paths)
+  {
+    std::vector<std::string> files;
+    for (const std::string& path : paths)
+    {
+      if (file_exists(path))
+      {
+        files.push_back(path);
+        outputs[path];
+      }
+      else if (outputs.erase(path) != 0)
+        std::remove(mirrored_path(directory, path, extension).c_str());
+    }
+
+    const uint64_t stored = cache != nullptr ? cache->stored() : 0;
+    parse_files<ParserType>(options, files, jobs, parse, [](const std::string&, const FileResult&) {});
+    if (cache != nullptr && cache->stored() != stored)
+      cache->Trim();
+  };
+
+  update(std::set<std::string>(inputs.files().begin(), inputs.files().end()));
+
+  std::vector<FileWatcher::Change> changes;
+  std::set<std::string> changed;
+  std::vector<std::string> found;
+  for (;;)
+  {
+    bool overflowed;
+    if (!watcher.Wait(changes, overflowed))
+    {
+      std::cerr << "Could not watch the files" << std::endl;
+      return false;
+    }
+
+    changed.clear();
+    if (overflowed)
+    {
+      // Changes were lost, look for new files and check all of them
+      for (std::size_t i = 0, count = inputs.directories().size(); i < count; ++i)
+      {
+        const InputList::Directory walkedDirectory = inputs.directories()[i];
+        if (walkedDirectory.relative.empty() && inputs.Walk(walkedDirectory.root, std::string(), found))
+        {
+          for (const std::string& path : found)
+            watch_file(path);
+        }
+      }
+      for (const auto& file : known)
+        changed.insert(file.second);
+    }
+
+    for (const FileWatcher::Change& change : changes)
+    {
+      const std::string path = join_path(change.directory, change.name);
+      auto walkedDirectory = walked.find(change.directory);
+      const std::string relative = walkedDirectory != walked.end() ? join_path(walkedDirectory->second.relative, change.name) : std::string();
+
+      if (change.isDirectory)
+      {
+        // The files of a directory that was removed are gone, those of one that was added are new
+        if (change.removed)
+        {
+          watcher.Unwatch(path);
+          for (const auto& file : known)
+          {
+            if (file.first.compare(0, path.size() + 1, path + '/') == 0)
+              changed.insert(file.second);
+          }
+        }
+        else if (walkedDirectory != walked.end() && inputs.Accepts(relative, true) &&
+          inputs.Walk(walkedDirectory->second.root, relative, found))
+        {
+          for (const std::string& file : found)
+          {
+            watch_file(file);
+            changed.insert(file);
+          }
+        }
+        continue;
+      }
+
+      auto file = known.find(path);
+      if (file != known.end())
+        changed.insert(file->second);
+      else if (!change.removed && walkedDirectory != walked.end() && inputs.Accepts(relative, false))
+      {
+        watch_file(path);
+        changed.insert(path);
+      }
+    }
+
+    watch_directories();
+    update(changed);
+  }
 }
 
 //----------------------------------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
   Options options;
-  std::string inputFile;
+  std::vector<std::string> inputFiles;
+  std::vector<std::string> includes;
+  std::vector<std::string> excludes;
+  std::string outputDirectory;
+  unsigned jobs = 1;
+  std::string cacheDirectory;
+  uint64_t cacheSize = 0;
+  bool watch = false;
   try
   {
     using namespace TCLAP;
@@ -29,17 +633,37 @@ int main(int argc, char** argv)
     MultiArg<std::string> functionName("f", "function", "The name of the function macro", false, "", cmd);
     ValueArg<std::string> propertyName("p", "property", "The name of the property macro", false, "PROPERTY", "", cmd);
     MultiArg<std::string> customMacro("m", "macro", "Custom macro names to parse", false, "", cmd);
-    UnlabeledValueArg<std::string> inputFileArg("inputFile", "The file to process", true, "", "", cmd);
+    SwitchArg typeTable("t", "types", "Write every distinct type once to a types table and refer to types by index", cmd, false);
+    SwitchArg compact("", "compact", "Write json without indentation and newlines", cmd, false);
+    SwitchArg binary("b", "binary", "Write the binary format instead of json", cmd, false);
+    MultiArg<std::string> include("", "include", "Only process the files in directories that match the pattern, *.h, *.hh, *.hpp and *.hxx by default", false, "pattern", cmd);
+    MultiArg<std::string> exclude("", "exclude", "Skip the files and directories in directories that match the pattern", false, "pattern", cmd);
+    ValueArg<std::string> output("o", "output", "Write the output of every file to this directory, at the path of the file", false, "", "directory", cmd);
+    ValueArg<unsigned> jobCount("j", "jobs", "The number of files to parse at the same time, 0 for one per core", false, 1, "count", cmd);
+    ValueArg<std::string> cacheArg("", "cache", "Keep the output of parsed files in this directory and reuse it for files that did not change", false, "", "directory", cmd);
+    ValueArg<uint64_t> cacheSizeArg("", "cache-size", "The size of the cache in MiB", false, 256, "size", cmd);
+    SwitchArg watchArg("w", "watch", "Keep running and parse files again when they change, requires an output directory", cmd, false);
+    UnlabeledMultiArg<std::string> inputFileArg("inputFiles", "The files, directories and @response files to process", true, "", cmd);
 
     cmd.parse(argc, argv);
 
-    inputFile = inputFileArg.getValue();
+    inputFiles = inputFileArg.getValue();
+    includes = include.getValue();
+    excludes = exclude.getValue();
+    outputDirectory = output.getValue();
+    jobs = jobCount.getValue();
+    cacheDirectory = cacheArg.getValue();
+    cacheSize = cacheSizeArg.getValue();
+    watch = watchArg.getValue();
     options.classNameMacro = className.getValue();
     options.enumNameMacro = enumName.getValue();
     options.functionNameMacro = functionName.getValue();
     options.customMacros = customMacro.getValue();
     options.propertyNameMacro = propertyName.getValue();
     options.constructorNameMacro = constructorName.getValue();
+    options.typeTable = typeTable.getValue();
+    options.compact = compact.getValue();
+    options.binary = binary.getValue();
   }
   catch (TCLAP::ArgException& e)
   {
@@ -47,20 +671,113 @@ int main(int argc, char** argv)
     return -1;
   }
 
-  // Open from file
-  std::ifstream t(inputFile);
-  if (!t.is_open())
+  if (jobs == 0)
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  InputList inputs;
+  if (!includes.empty())
+    inputs.SetIncludes(includes);
+  inputs.SetExcludes(excludes);
+  for (const std::string& inputFile : inputFiles)
+  {
+    if (!inputs.Add(inputFile))
+    {
+      std::cerr << inputs.error() << std::endl;
+      return -1;
+    }
+  }
+
+  // Results of earlier runs
+  ResultCache cache;
+  ResultCache* usedCache = nullptr;
+  if (!cacheDirectory.empty())
+  {
+    if (!make_parent_directories(cacheDirectory + '/') || !cache.Open(cacheDirectory, cacheSize * 1024 * 1024, options))
+    {
+      std::cerr << "Could not use the cache directory " << cacheDirectory << std::endl;
+      return -1;
+    }
+    usedCache = &cache;
+  }
+
+  int result = 0;
+  if (watch)
   {
-    std::cerr << "Could not open " << inputFile << std::endl;
+    // Output directory kept up to date
+    if (outputDirectory.empty())
+    {
+      std::cerr << "Watching files requires an output directory" << std::endl;
+      return -1;
+    }
+
+    if (options.binary)
+      watch_directory<BinaryParser>(options, inputs, outputDirectory, jobs, usedCache);
+    else if (options.compact)
+      watch_directory<CompactParser>(options, inputs, outputDirectory, jobs, usedCache);
+    else
+      watch_directory<Parser>(options, inputs, outputDirectory, jobs, usedCache);
     return -1;
   }
+  else if (!outputDirectory.empty())
+  {
+    // Files written to a directory
+    bool succeeded;
+    if (options.binary)
+      succeeded = parse_to_directory<BinaryParser>(options, inputs.files(), outputDirectory, jobs, usedCache);
+    else if (options.compact)
+      succeeded = parse_to_directory<CompactParser>(options, inputs.files(), outputDirectory, jobs, usedCache);
+    else
+      succeeded = parse_to_directory<Parser>(options, inputs.files(), outputDirectory, jobs, usedCache);
+    result = succeeded ? 0 : -1;
+  }
+  else if (inputFiles.size() != 1 || inputs.files().size() != 1 || inputs.files()[0] != inputFiles[0])
+  {
+    // Several files written to stdout as one document
+    if (options.binary)
+    {
+      std::cerr << "Binary output of more than one file requires an output directory" << std::endl;
+      return -1;
+    }
 
-  std::stringstream buffer;
-  buffer << t.rdbuf();
+    bool succeeded;
+    if (options.compact)
+      succeeded = parse_to_document<CompactParser>(options, inputs.files(), jobs, usedCache);
+    else
+      succeeded = parse_to_document<Parser>(options, inputs.files(), jobs, usedCache);
+    result = succeeded ? 0 : -1;
+  }
+  else
+  {
+    // Open from file
+    const std::string& inputFile = inputFiles[0];
+    InputFile input;
+    if (!input.Open(inputFile))
+    {
+      std::cerr << "Could not open " << inputFile << std::endl;
+      return -1;
+    }
+
+    bool succeeded;
+    if (options.binary)
+    {
+#ifdef _WIN32
+      _setmode(kStandardOutput, _O_BINARY);
+#endif
+      succeeded = parse_to_stdout<BinaryParser>(options, inputFile, input, usedCache);
+    }
+    else if (options.compact)
+      succeeded = parse_to_stdout<CompactParser>(options, inputFile, input, usedCache);
+    else
+      succeeded = parse_to_stdout<Parser>(options, inputFile, input, usedCache);
+
+    // The json of a failed parse ends where the error was found
+    if (!options.binary)
+      std::cout << std::endl;
+    result = succeeded ? 0 : -1;
+  }
 
-  Parser parser(options);
-  if (parser.Parse(buffer.str().c_str()))
-    std::cout << parser.result() << std::endl;
-  
-	return 0;
+  // Keep the cache within its size once this run added to it
+  if (cache.stored() != 0)
+    cache.Trim();
+  return result;
 }
@@ -11,4 +11,13 @@ struct Options
   std::string propertyNameMacro;
   std::vector<std::string> customMacros;
   std::string constructorNameMacro;
+
+  /// Write every distinct type once to a types table and refer to types by their index in it
+  bool typeTable = false;
+
+  /// Write json without indentation and newlines
+  bool compact = false;
+
+  /// Write the binary format of binary_format.h instead of json
+  bool binary = false;
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "output_stream.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+  /// Size of the buffer when writing to a file descriptor
+  const std::size_t kFileBufferSize = 64 * 1024;
+
+  /// Initial size of the buffer when collecting the output in memory
+  const std::size_t kMemoryBufferSize = 4 * 1024;
+}
+
+//--------------------------------------------------------------------------------------------------
+OutputStream::OutputStream() :
+  fd_(-1),
+  failed_(false),
+  size_(0)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+void OutputStream::Open(int fd)
+{
+  Flush();
+  fd_ = fd;
+  if (fd_ >= 0 && buffer_.size() < kFileBufferSize)
+    buffer_.resize(kFileBufferSize);
+}
+
+//--------------------------------------------------------------------------------------------------
+void OutputStream::Clear()
+{
+  size_ = 0;
+  failed_ = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+void OutputStream::Flush()
+{
+  if (fd_ < 0)
+    return;
+
+  const char* data = buffer_.data();
+  std::size_t remaining = failed_ ? 0 : size_;
+  while (remaining > 0)
+  {
+#ifdef _WIN32
+    int written = _write(fd_, data, static_cast<unsigned>(remaining));
+#else
+    ssize_t written = write(fd_, data, remaining);
+#endif
+    if (written < 0 && errno == EINTR)
+      continue;
+
+    if (written <= 0)
+    {
+      failed_ = true;
+      break;
+    }
+
+    data += written;
+    remaining -= static_cast<std::size_t>(written);
+  }
+
+  size_ = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+void OutputStream::Write(const char* data, std::size_t size)
+{
+  while (size > 0)
+  {
+    if (size_ == buffer_.size())
+      Overflow();
+
+    const std::size_t count = std::min(size, buffer_.size() - size_);
+    std::memcpy(buffer_.data() + size_, data, count);
+    size_ += count;
+    data += count;
+    size -= count;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void OutputStream::Overflow()
+{
+  if (fd_ >= 0)
+    Flush();
+  else
+    buffer_.resize(buffer_.empty() ? kMemoryBufferSize : buffer_.size() * 2);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/// File descriptor of the standard output
+static const int kStandardOutput = 1;
+
+/**
+ * @brief Output stream for the rapidjson writers that either collects the output in memory or writes
+ * it to a file descriptor.
+ * @details In memory the buffer grows to hold the whole output. When writing to a file descriptor the
+ * buffer has a fixed size and is written out whenever it is full, so the memory used does not depend
+ * on the size of the output. Write errors are remembered and all further output is discarded.
+ */
+class OutputStream
+{
+public:
+  typedef char Ch;
+
+  OutputStream();
+
+  // Do not allow copy or move
+  OutputStream(const OutputStream& other) = delete;
+  OutputStream(OutputStream&& other) = delete;
+
+  /// Flushes any buffered output and writes all further output to the given file descriptor, or to
+  /// memory if fd is negative. The file descriptor is not closed by the stream.
+  void Open(int fd);
+
+  /// Discards the buffered output and any previous write error
+  void Clear();
+
+  /// Writes the buffered output to the file descriptor, does nothing in memory
+  void Flush();
+
+  /// Appends a character
+  void Put(char c)
+  {
+    if (size_ == buffer_.size())
+      Overflow();
+    buffer_[size_++] = c;
+  }
+
+  /// Appends the given characters
+  void Write(const char* data, std::size_t size);
+
+  /// Returns the output collected in memory, or the part not yet written to the file descriptor
+  const char* data() const { return buffer_.data(); }
+  std::size_t size() const { return size_; }
+
+  /// Returns true if writing to the file descriptor failed
+  bool failed() const { return failed_; }
+
+private:
+  /// Makes room in a full buffer
+  void Overflow();
+
+private:
+  int fd_;
+  bool failed_;
+  std::size_t size_;
+  std::vector<char> buffer_;
+};
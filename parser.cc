@@ -3,150 +3,116 @@
 #include <algorithm>
 #include "parser.h"
 #include "token.h"
+#include "char_scan.h"
 #include <cstdarg>
 
-//-------------------------------------------------------------------------------------------------
-// Class used to write a typenode structure to json
-//-------------------------------------------------------------------------------------------------
-class TypeNodeWriter : public TypeNodeVisitor
-{
-public:
-  TypeNodeWriter(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer) :
-    writer_(writer) {}
-
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(FunctionNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("function");
-
-    writer_.String("returnType");
-    VisitNode(*node.returns);
-
-    writer_.String("arguments");
-    writer_.StartArray();
-    for (auto& arg : node.arguments)
-    {
-      writer_.StartObject();
-      if (!arg->name.empty())
-      {
-        writer_.String("name");
-        writer_.String(arg->name.c_str());
-      }
-      writer_.String("type");
-      VisitNode(*arg->type);
-      writer_.EndObject();
-    }
-    writer_.EndArray();
-  }
-
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(LReferenceNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("lreference");
-
-    writer_.String("baseType");
-    VisitNode(*node.base);
-  }
-
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(LiteralNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("literal");
-
-    writer_.String("name");
-    writer_.String(node.name.c_str());
-  }
+namespace {
+  /// Memory the type tree of a parser keeps between inputs, more is freed by Reset
+  const std::size_t kMaxKeptTypeBytes = 64 * 1024;
 
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(PointerNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("pointer");
-
-    writer_.String("baseType");
-    VisitNode(*node.base);
-  }
-
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(ReferenceNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("reference");
+  /// Identifiers a parser keeps interned between inputs. Beyond this Reset removes all identifiers but
+  /// the predefined ones and the annotation macros.
+  const std::size_t kMaxKeptAtoms = 64 * 1024;
+}
 
-    writer_.String("baseType");
-    VisitNode(*node.base);
-  }
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+BasicParser<HandlerType>::BasicParser(const Options &options, HandlerType& handler) : options_(options), handler_(handler)
+{
+  // Earlier registrations take precedence if a name is used more than once
+  AddDeclaration(options_.enumNameMacro, DeclarationType::kEnum);
+  AddDeclaration(options_.classNameMacro, DeclarationType::kClass);
+  for (std::size_t i = 0; i < options_.functionNameMacro.size(); ++i)
+    AddDeclaration(options_.functionNameMacro[i], DeclarationType::kFunction, static_cast<uint32_t>(i));
+  AddDeclaration(options_.constructorNameMacro, DeclarationType::kConstructor);
+  AddDeclaration(options_.propertyNameMacro, DeclarationType::kProperty);
+  AddDeclaration(kAtomNamespace, DeclarationType::kNamespace);
+  AddDeclaration(kAtomPublic, DeclarationType::kAccessControl);
+  AddDeclaration(kAtomProtected, DeclarationType::kAccessControl);
+  AddDeclaration(kAtomPrivate, DeclarationType::kAccessControl);
+  for (std::size_t i = 0; i < options_.customMacros.size(); ++i)
+    AddDeclaration(options_.customMacros[i], DeclarationType::kCustomMacro, static_cast<uint32_t>(i));
+
+  // The atoms of the declarations have to stay when the table is truncated
+  declarationAtomCount_ = atoms_.size();
+}
 
-  //-------------------------------------------------------------------------------------------------
-  virtual void Visit(TemplateNode& node) override
-  {
-    writer_.String("type");
-    writer_.String("template");
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::AddDeclaration(Atom atom, DeclarationType type, uint32_t macro)
+{
+  if (atom >= declarations_.size())
+    declarations_.resize(atom + 1, Declaration{ DeclarationType::kNone, 0 });
 
-    writer_.String("name");
-    writer_.String(node.name.c_str());
+  if (declarations_[atom].type == DeclarationType::kNone)
+    declarations_[atom] = Declaration{ type, macro };
 
-    writer_.String("arguments");
-    writer_.StartArray();
-    for (auto& arg : node.arguments)
-      VisitNode(*arg);
-    writer_.EndArray();
-  }
+  // The tokenizer needs to know where all of them are
+  filter_.Add(atoms_.Name(atom).str());
+}
 
-  //-------------------------------------------------------------------------------------------------
-  virtual void VisitNode(TypeNode &node) override
-  {
-    writer_.StartObject();
-    if (node.isConst)
-    {
-      writer_.String("const");
-      writer_.Bool(true);
-    }
-    if (node.isMutable)
-    {
-      writer_.String("mutable");
-      writer_.Bool(true);
-    }
-    if (node.isVolatile)
-    {
-      writer_.String("volatile");
-      writer_.Bool(true);
-    }
-    TypeNodeVisitor::VisitNode(node);
-    writer_.EndObject();
-  }
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::AddDeclaration(const std::string& macroName, DeclarationType type, uint32_t macro)
+{
+  if (macroName.empty())
+    return;
 
-private:
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> &writer_;
-};
+  AddDeclaration(atoms_.Intern(macroName), type, macro);
+}
 
 //--------------------------------------------------------------------------------------------------
-Parser::Parser(const Options &options) : options_(options), writer_(buffer_)
+template<typename HandlerType>
+BasicParser<HandlerType>::~BasicParser()
 {
 
 }
 
 //--------------------------------------------------------------------------------------------------
-Parser::~Parser()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::Parse(const char *input)
 {
+  return Parse(input, std::char_traits<char>::length(input));
+}
 
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::Reset()
+{
+  types_.Shrink(kMaxKeptTypeBytes);
+  if (atoms_.size() > kMaxKeptAtoms)
+    atoms_.Truncate(declarationAtomCount_);
+  meta_.clear();
+  text_.clear();
+  textRanges_.clear();
+  landmarkPositions_.clear();
+  landmarks_.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::Parse(const char *input)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::Parse(const char *input, std::size_t length)
 {
-  // Pass the input to the tokenizer
-  Reset(input);
+  Reset();
 
-  // Start the array
-  writer_.StartArray();
+  // Find the annotations and scope keywords, then lex the input in one go. Only the annotated
+  // declarations are lexed in full, without the bodies of functions and constructors.
+  filter_.FindAll(input, length, landmarkPositions_);
+  for (std::size_t position : landmarkPositions_)
+  {
+    const char* name = input + position;
+    const Atom atom = atoms_.Intern(name, static_cast<std::size_t>(ScanIdentifier(name, input + length) - name));
+    const DeclarationType type = declarations_[atom].type;
+    const bool annotation = type != DeclarationType::kNamespace && type != DeclarationType::kAccessControl;
+    const bool skipBody = type == DeclarationType::kFunction || type == DeclarationType::kConstructor;
+    landmarks_.push_back(Landmark{ position, annotation, skipBody });
+  }
+  Tokenizer::Reset(input, length);
+  Tokenize(landmarks_);
 
   // Reset scope
   topScope_ = scopes_;
-  topScope_->name = "";
+  topScope_->name = kAtomNone;
   topScope_->type = ScopeType::kGlobal;
   topScope_->currentAccessControlType = AccessControlType::kPublic;
 
@@ -155,15 +121,12 @@ bool Parser::Parse(const char *input)
   {
   }
 
-  // End the array
-  if(!HasError())
-    writer_.EndArray();
-
   return !HasError();
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseStatement()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseStatement()
 {
   Token token;
   if(!GetToken(token))
@@ -176,37 +139,46 @@ bool Parser::ParseStatement()
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseDeclaration(Token &token)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseDeclaration(Token &token)
 {
-  std::vector<std::string>::const_iterator customMacroIt;
   if (token.token == "#")
       return ParseDirective();
   else if (token.token == ";")
       return true; // Empty statement
-  else if (token.token == options_.enumNameMacro)
-      return ParseEnum(token);
-  else if (token.token == options_.classNameMacro)
-      return ParseClass(token);
-  else if ((customMacroIt = std::find(options_.functionNameMacro.begin(), options_.functionNameMacro.end(), token.token)) != options_.functionNameMacro.end())
-      return ParseFunction(token, *customMacroIt);
-  else if (token.token == options_.constructorNameMacro)
-      return ParseConstructor(token);
-  else if(token.token == options_.propertyNameMacro)
+
+  // Look up the declaration by the atom of its first token, atoms of other identifiers and of all
+  // other tokens are past the end of the table or map to kNone
+  const Declaration declaration = token.atom < declarations_.size() ?
+    declarations_[token.atom] : Declaration{ DeclarationType::kNone, 0 };
+
+  switch (declaration.type)
+  {
+  case DeclarationType::kEnum:
+    return ParseEnum(token);
+  case DeclarationType::kClass:
+    return ParseClass(token);
+  case DeclarationType::kFunction:
+    return ParseFunction(token, options_.functionNameMacro[declaration.macro]);
+  case DeclarationType::kConstructor:
+    return ParseConstructor(token);
+  case DeclarationType::kProperty:
     return ParseProperty(token);
-  else if (token.token == "namespace")
+  case DeclarationType::kNamespace:
     return ParseNamespace();
-  else if (ParseAccessControl(token, topScope_->currentAccessControlType))
+  case DeclarationType::kAccessControl:
+    ParseAccessControl(token, topScope_->currentAccessControlType);
     return RequireSymbol(":");
-  else if ((customMacroIt = std::find(options_.customMacros.begin(), options_.customMacros.end(), token.token)) != options_.customMacros.end())
-    return ParseCustomMacro(token, *customMacroIt);
-  else
+  case DeclarationType::kCustomMacro:
+    return ParseCustomMacro(token, options_.customMacros[declaration.macro]);
+  default:
     return SkipDeclaration(token);
-
-  return true;
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseDirective()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseDirective()
 {
   Token token;
 
@@ -215,48 +187,52 @@ bool Parser::ParseDirective()
     return Error("Missing compiler directive after #");
 
   bool multiLineEnabled = false;
-  if(token.token == "define")
+  if(token.atom == kAtomDefine)
   {
     multiLineEnabled = true;
   }
-  else if(token.token == "include")
+  else if(token.atom == kAtomInclude)
   {
     Token includeToken;
     GetToken(includeToken, true);
 
-    writer_.StartObject();
-    writer_.String("type");
-    writer_.String("include");
-    writer_.String("file");
-    writer_.String(includeToken.token.c_str());
-    writer_.EndObject();
+    IncludeInfo info;
+    info.file = includeToken.token;
+    handler_.Include(info);
   }
 
-  // Skip past the end of the token
-  char lastChar = '\n';
-  do
-  {
-    // Skip to the end of the line
-    char c;
-    while(!this->is_eof() && (c = GetChar()) != '\n')
-      lastChar = c;
-
-  } while(multiLineEnabled && lastChar == '\\');
+  // Skip past the end of the directive
+  SkipDirective(multiLineEnabled);
 
   return true;
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::SkipDeclaration(Token &token)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::SkipDeclaration(Token &token)
 {
   int32_t scopeDepth = 0;
   while(GetToken(token))
   {
+    // String constants such as "}" do not count
+    if(token.tokenType != TokenType::kSymbol)
+      continue;
+
     if(token.token == ";" && scopeDepth == 0)
       break;
 
     if(token.token == "{")
+    {
+      // Jump over the entire scope if the matching brace is known. At a negative depth a ';' in the
+      // scope ends the declaration, so the tokens have to be visited one by one.
+      if(scopeDepth >= 0 && SkipToClosingBrace(token) && GetToken(token))
+      {
+        if(scopeDepth == 0)
+          break;
+        continue;
+      }
       scopeDepth++;
+    }
 
     if(token.token == "}")
     {
@@ -270,83 +246,61 @@ bool Parser::SkipDeclaration(Token &token)
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseEnum(Token &startToken)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseEnum(Token &startToken)
 {
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("enum");
-  writer_.String("line");
-  writer_.Uint((unsigned)startToken.startLine);
-
-  WriteCurrentAccessControlType();
+  EnumInfo& info = enum_;
+  StartDeclaration(info, startToken);
+  info.base = StringView();
+  info.members.clear();
 
   if (!ParseMacroMeta())
     return false;
 
-  if (!RequireIdentifier("enum"))
+  if (!RequireIdentifier(kAtomEnum))
     return false;
 
   // C++1x enum class type?
-  bool isEnumClass = MatchIdentifier("class");
+  info.isEnumClass = MatchIdentifier(kAtomClass);
 
   // Parse enum name
   Token enumToken;
   if (!GetIdentifier(enumToken))
     return Error("Missing enum name");
-
-  writer_.String("name");
-  writer_.String(enumToken.token.c_str());
-
-  if (isEnumClass)
-  {
-    writer_.String("cxxclass");
-    writer_.Bool(isEnumClass);
-  }
+  info.name = enumToken.token;
 
   // Parse C++1x enum base
-  if(isEnumClass && MatchSymbol(":"))
+  if(info.isEnumClass && MatchSymbol(":"))
   {
     Token baseToken;
     if (!GetIdentifier(baseToken))
       return Error("Missing enum type specifier after :");
-
-    // Validate base token
-    writer_.String("base");
-    writer_.String(baseToken.token.c_str());
+    info.base = baseToken.token;
   }
 
   // Require opening brace
   RequireSymbol("{");
 
-  writer_.String("members");
-  writer_.StartArray();
-
   // Parse all the values
   Token token;
   while(GetIdentifier(token))
   {
-    writer_.StartObject();
-    
-    // Store the identifier
-    writer_.String("key");
-    writer_.String(token.token.c_str());
+    EnumeratorInfo member = EnumeratorInfo();
+    member.key = token.token;
 
     // Parse constant
+    TypeRange value = { static_cast<uint32_t>(text_.size()), 0 };
     if(MatchSymbol("="))
     {
-      // Just parse the value, not doing anything with it atm
-      std::string value;
+      // Just collect the text of the value
+      member.hasValue = true;
       while (GetToken(token) && (token.tokenType != TokenType::kSymbol || (token.token != "," && token.token != "}")))
-      {
-        value += token.token;
-      }
+        AppendText(value, token);
       UngetToken(token);
-  
-      writer_.String("value");
-      writer_.String(value.c_str());
     }
 
-    writer_.EndObject();
+    info.members.push_back(member);
+    textRanges_.push_back(value);
 
     // Next value?
     if(!MatchSymbol(","))
@@ -355,20 +309,22 @@ bool Parser::ParseEnum(Token &startToken)
 
   if (!RequireSymbol("}"))
     return false;
-  writer_.EndArray();
 
   MatchSymbol(";");
 
-  writer_.EndObject();
+  for (std::size_t i = 0; i < info.members.size(); ++i)
+    if (info.members[i].hasValue)
+      info.members[i].value = Text(textRanges_[i]);
 
+  FinishDeclaration(info);
+  handler_.Enum(info);
   return true;
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseMacroMeta()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseMacroMeta()
 {
-  writer_.String("meta");
-
   if (!RequireSymbol("("))
     return false;
   if (!ParseMetaSequence())
@@ -381,10 +337,9 @@ bool Parser::ParseMacroMeta()
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseMetaSequence()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseMetaSequence()
 {
-  writer_.StartObject();
-
   if(!MatchSymbol(")"))
   {
     do
@@ -394,103 +349,107 @@ bool Parser::ParseMetaSequence()
       if (!GetIdentifier(keyToken))
         return Error("Expected identifier in meta sequence");
 
-      writer_.String(keyToken.token.c_str());
+      MetaEntry entry = MetaEntry();
+      entry.key = keyToken.token;
 
       // Simple value?
       if (MatchSymbol("=")) {
-        Token token;
-        if (!GetToken(token))
-          throw; // Expected token
+        if (!GetToken(entry.value))
+          return Error("Missing value of %s", std::string(keyToken.token.data, keyToken.token.length).c_str());
 
-        WriteToken(token);
+        entry.type = MetaEntry::Type::kValue;
+        meta_.push_back(entry);
       }
       // Compound value
       else if (MatchSymbol("("))
       {
+        entry.type = MetaEntry::Type::kSequence;
+        const std::size_t index = meta_.size();
+        meta_.push_back(entry);
         if (!ParseMetaSequence())
           return false;
-        // No value
+        meta_[index].count = meta_.size() - index - 1;
       }
+      // No value
       else
-        writer_.Null();
+        meta_.push_back(entry);
     } while (MatchSymbol(","));
 
     MatchSymbol(")");
   }
 
-  writer_.EndObject();
   return true;
 }
 
 //--------------------------------------------------------------------------------------------------
-void Parser::PushScope(const std::string &name, ScopeType scopeType, AccessControlType accessControlType)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::PushScope(Atom name, ScopeType scopeType, AccessControlType accessControlType)
 {
   if(topScope_ == scopes_ + (sizeof(scopes_) / sizeof(Scope)) - 1)
-    throw; // Max scope depth
+    return Error("Maximum scope depth exceeded");
 
   topScope_++;
   topScope_->type = scopeType;
   topScope_->name = name;
   topScope_->currentAccessControlType = accessControlType;
+  return true;
 }
 
 //--------------------------------------------------------------------------------------------------
-void Parser::PopScope()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::PopScope()
 {
   if(topScope_ == scopes_)
-    throw; // Scope error
+    return Error("Unbalanced scope");
 
   topScope_--;
+  return true;
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseNamespace()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseNamespace()
 {
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("namespace");
-
   Token token;
   if (!GetIdentifier(token))
     return Error("Missing namespace name");
 
-  writer_.String("name");
-  writer_.String(token.token.c_str());
-
   if (!RequireSymbol("{"))
     return false;
 
-  writer_.String("members");
-  writer_.StartArray();
+  NamespaceInfo info;
+  info.name = token.token;
+  handler_.StartNamespace(info);
 
-  PushScope(token.token, ScopeType::kNamespace, AccessControlType::kPublic);
+  if (!PushScope(token.atom, ScopeType::kNamespace, AccessControlType::kPublic))
+    return false;
 
   while (!MatchSymbol("}"))
     if (!ParseStatement())
       return false;
 
-  PopScope();
-
-  writer_.EndArray();
+  if (!PopScope())
+    return false;
 
-  writer_.EndObject();
+  handler_.EndNamespace();
   return true;
 }
 
 //-------------------------------------------------------------------------------------------------
-bool Parser::ParseAccessControl(const Token &token, AccessControlType& type)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseAccessControl(const Token &token, AccessControlType& type)
 {
-  if (token.token == "public")
+  if (token.atom == kAtomPublic)
   {
     type = AccessControlType::kPublic;
     return true;
   }
-  else if (token.token == "protected")
+  else if (token.atom == kAtomProtected)
   {
     type = AccessControlType::kProtected;
     return true;
   }
-  else if (token.token == "private")
+  else if (token.atom == kAtomPrivate)
   {
     type = AccessControlType::kPrivate;
     return true;
@@ -499,193 +458,135 @@ bool Parser::ParseAccessControl(const Token &token, AccessControlType& type)
   return false;
 }
 
-//-------------------------------------------------------------------------------------------------
-void Parser::WriteCurrentAccessControlType()
-{
-  // Writing access is not required if the current scope is not owned by a class
-  if (topScope_->type != ScopeType::kClass)
-    return;
-
-  WriteAccessControlType(current_access_control_type());
-}
-
-//-------------------------------------------------------------------------------------------------
-void Parser::WriteAccessControlType(AccessControlType type)
-{
-  writer_.String("access");
-  switch (type)
-  {
-  case AccessControlType::kPublic:
-    writer_.String("public");
-    break;
-  case AccessControlType::kProtected:
-    writer_.String("protected");
-    break;
-  case AccessControlType::kPrivate:
-    writer_.String("private");
-    break;
-  default:
-    throw; // Unknown access control type
-  }
-}
-
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseClass(Token &token)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseClass(Token &token)
 {
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("class");
-  writer_.String("line");
-  writer_.Uint((unsigned)token.startLine);
-
-  WriteCurrentAccessControlType();
-  if (!ParseComment())
+  ClassInfo& info = class_;
+  StartDeclaration(info, token);
+  info.isTemplate = false;
+  info.templateArguments.clear();
+  info.parents.clear();
+
+  if (!ParseComment(info))
     return false;
   if (!ParseMacroMeta())
     return false;
 
-  if(MatchIdentifier("template") && !ParseClassTemplate())
+  if(MatchIdentifier(kAtomTemplate) && !ParseClassTemplate(info))
     return false;
 
-  bool isStruct = MatchIdentifier("struct");
-  if (!(MatchIdentifier("class") || isStruct))
+  const bool isStruct = MatchIdentifier(kAtomStruct);
+  if (!(MatchIdentifier(kAtomClass) || isStruct))
     return Error("Missing identifier class or struct");
-
-  writer_.String("isstruct");
-  writer_.Bool(isStruct);
+  info.isStruct = isStruct;
 
   // Get the class name
   Token classNameToken;
   if(!GetIdentifier(classNameToken))
-    throw; // Missing class name
-
-  writer_.String("name");
-  writer_.String(classNameToken.token.c_str());
+    return Error("Missing class name");
+  info.name = classNameToken.token;
 
   // Match base types
   if(MatchSymbol(":"))
   {
-    writer_.String("parents");
-    writer_.StartArray();
-
     do
     {
-      writer_.StartObject();
-
       Token accessOrName;
       if (!GetIdentifier(accessOrName))
-        throw; // Missing class or access control specifier
+        return Error("Missing class or access control specifier");
 
       // Parse the access control specifier
-      AccessControlType accessControlType = AccessControlType::kPrivate;
-      if (!ParseAccessControl(accessOrName, accessControlType))
+      ParentInfo parent;
+      parent.access = AccessControlType::kPrivate;
+      if (!ParseAccessControl(accessOrName, parent.access))
         UngetToken(accessOrName);
-      WriteAccessControlType(accessControlType);
-      
+
       // Get the name of the class
-      writer_.String("name");
-      if (!ParseType())
+      parent.type = ParseTypeNode();
+      if (parent.type == kNoTypeNode)
         return false;
 
-      writer_.EndObject();
+      info.parents.push_back(parent);
     }
     while (MatchSymbol(","));
-
-    writer_.EndArray();
   }
 
   if (!RequireSymbol("{"))
     return false;
 
-  writer_.String("members");
-  writer_.StartArray();
+  // The info is reused by the members, so it is reported before they are parsed
+  FinishDeclaration(info);
+  handler_.StartClass(info);
 
-  PushScope(classNameToken.token, ScopeType::kClass, isStruct ? AccessControlType::kPublic : AccessControlType::kPrivate);
+  if (!PushScope(classNameToken.atom, ScopeType::kClass, isStruct ? AccessControlType::kPublic : AccessControlType::kPrivate))
+    return false;
 
   while (!MatchSymbol("}"))
     if (!ParseStatement())
       return false;
 
-  PopScope();
-
-  writer_.EndArray();
+  if (!PopScope())
+    return false;
 
   if (!RequireSymbol(";"))
     return false;
 
-  writer_.EndObject();
+  handler_.EndClass();
   return true;
 }
 
-//-------------------------------------------------------------------------------------------------
-bool Parser::ParseProperty(Token &token)
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseProperty(Token &token)
 {
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("property");
-  writer_.String("line");
-  writer_.Uint((unsigned) token.startLine);
+  PropertyInfo& info = property_;
+  StartDeclaration(info, token);
 
   if (!ParseMacroMeta())
     return false;
 
-  WriteCurrentAccessControlType();
-
   // Process method specifiers in any particular order
-  bool isMutable = false, isStatic = false;
+  info.isMutable = false;
+  info.isStatic = false;
   for (bool matched = true; matched;)
   {
-    matched = (!isMutable && (isMutable = MatchIdentifier("mutable"))) ||
-      (!isStatic && (isStatic = MatchIdentifier("static")));
-  }
-
-  // Check mutable
-  if(isMutable)
-  {
-    writer_.String("mutable");
-    writer_.Bool(true);
-  }
-
-  // Check mutable
-  if (isStatic)
-  {
-    writer_.String("static");
-    writer_.Bool(true);
+    matched = (!info.isMutable && (info.isMutable = MatchIdentifier(kAtomMutable))) ||
+      (!info.isStatic && (info.isStatic = MatchIdentifier(kAtomStatic)));
   }
 
   // Parse the type
-  writer_.String("dataType");
-  if (!ParseType())
+  info.dataType = ParseTypeNode();
+  if (info.dataType == kNoTypeNode)
     return false;
 
   // Parse the name
   Token nameToken;
   if(!GetIdentifier(nameToken))
-    throw; // Expected a property name
-
-  writer_.String("name");
-  writer_.String(nameToken.token.c_str());
+    return Error("Missing property name");
+  info.name = nameToken.token;
 
   // Parse array
-  writer_.String("elements");
-  if (MatchSymbol("["))
-  {
-	  Token arrayToken;
-	  if(!GetConst(arrayToken))
-		  if(!GetIdentifier(arrayToken))
-			  throw; // Expected a property name
-	  writer_.String(arrayToken.token.c_str());
-
-	  if(!MatchSymbol("]"))
-		  throw;
-  }
-  else
+  info.isArray = MatchSymbol("[");
+  info.elements = StringView();
+  if (info.isArray)
   {
-	writer_.Null();
-  }
+    Token arrayToken;
+    if(!GetConst(arrayToken))
+      if(!GetIdentifier(arrayToken))
+        return Error("Missing array size");
+
+    // The token may refer to its own unescaped text, so keep a copy
+    TypeRange elements = { static_cast<uint32_t>(text_.size()), 0 };
+    AppendText(elements, arrayToken);
+    info.elements = Text(elements);
 
-  writer_.EndObject();
+    if(!RequireSymbol("]"))
+      return false;
+  }
 
+  FinishDeclaration(info);
+  handler_.Property(info);
 
   // Skip until the end of the definition
   Token t;
@@ -697,183 +598,58 @@ bool Parser::ParseProperty(Token &token)
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseConstructor(Token& token)
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseConstructor(Token& token)
 {
-    writer_.StartObject();
-    writer_.String("type");
-    writer_.String("constructor");
-    writer_.String("line");
-    writer_.Uint((unsigned) token.startLine);
-
-    if (!ParseComment()) return false;
-    if (!ParseMacroMeta()) return false;
-
-    WriteCurrentAccessControlType();
-
-    bool isInline = false;
-    for (bool matched = true; matched;)
-    {
-        matched = !isInline && (isInline = MatchIdentifier("inline"));
-    }
-
-    if (isInline)
-    {
-        writer_.String("inline");
-        writer_.Bool(isInline);
-    }
-
-    // Parse the name of the constructor
-    Token nameToken;
-    if (!GetIdentifier(nameToken)) throw;
-
-    writer_.String("name");
-    writer_.String(nameToken.token.c_str());
-
-    writer_.String("arguments");
-    writer_.StartArray();
-
-    // Start argument list from here
-    MatchSymbol("(");
-
-    // Is there an argument list in the first place or is it closed right away?
-    if (!MatchSymbol(")"))
-    {
-        // Walk over all arguments
-        do
-        {
-            writer_.StartObject();
-
-            // Get the type of the argument
-            writer_.String("type");
-            if (!ParseType())
-                return false;
-
-            // Parse the name of the function
-            writer_.String("name");
-            if (!GetIdentifier(nameToken))
-                throw; // Expected identifier
-            writer_.String(nameToken.token.c_str());
-
-            // Parse default value
-            if (MatchSymbol("="))
-            {
-                writer_.String("defaultValue");
-
-                std::string defaultValue;
-                Token token;
-                GetToken(token);
-                if (token.tokenType == TokenType::kConst)
-                    WriteToken(token);
-                else
-                {
-                    do
-                    {
-                        if (token.token == "," ||
-                            token.token == ")")
-                        {
-                            UngetToken(token);
-                            break;
-                        }
-                        defaultValue += token.token;
-                    } while (GetToken(token));
-                    writer_.String(defaultValue.c_str());
-                }
-            }
-
-            writer_.EndObject();
-        } while (MatchSymbol(",")); // Only in case another is expected
-
-        MatchSymbol(")");
-    }
-
-    writer_.EndArray();
-
-    // Is default?
-    if (MatchSymbol("="))
-    {
-        Token token;
-        if (!GetToken(token) || token.token != "default")
-            throw; // Expected nothing else than default
-
-        writer_.String("default");
-        writer_.Bool(true);
-    }
-
-    writer_.EndObject();
-
-    // Skip either the ; or the body of the function
-    Token skipToken;
-    if (!SkipDeclaration(skipToken))
-        return false;
-    return true;
-}
+  ConstructorInfo& info = constructor_;
+  StartDeclaration(info, token);
 
-//--------------------------------------------------------------------------------------------------
-bool Parser::ParseFunction(Token &token, const std::string& macroName)
-{
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("function");
-  writer_.String("macro");
-  writer_.String(macroName.c_str());
-  writer_.String("line");
-  writer_.Uint((unsigned) token.startLine);
-
-  if (!ParseComment())
+  if (!ParseComment(info))
     return false;
-
   if (!ParseMacroMeta())
     return false;
 
-  WriteCurrentAccessControlType();
-
-  // Process method specifiers in any particular order
-  bool isVirtual = false, isInline = false, isConstExpr = false, isStatic = false;
-  for(bool matched = true; matched;)
+  info.isInline = false;
+  for (bool matched = true; matched;)
   {
-    matched = (!isVirtual && (isVirtual = MatchIdentifier("virtual"))) ||
-        (!isInline && (isInline = MatchIdentifier("inline"))) ||
-        (!isConstExpr && (isConstExpr = MatchIdentifier("constexpr"))) ||
-        (!isStatic && (isStatic = MatchIdentifier("static")));
+    matched = !info.isInline && (info.isInline = MatchIdentifier(kAtomInline));
   }
 
-  // Write method specifiers
-  if (isVirtual)
-  {
-    writer_.String("virtual");
-    writer_.Bool(isVirtual);
-  }
-  if (isInline)
-  {
-    writer_.String("inline");
-    writer_.Bool(isInline);
-  }
-  if (isConstExpr)
-  {
-    writer_.String("constexpr");
-    writer_.Bool(isConstExpr);
-  }
-  if (isStatic)
-  {
-    writer_.String("static");
-    writer_.Bool(isStatic);
-  }
+  // Parse the name of the constructor
+  Token nameToken;
+  if (!GetIdentifier(nameToken))
+    return Error("Missing constructor name");
+  info.name = nameToken.token;
 
-  // Parse the return type
-  writer_.String("returnType");
-  if (!ParseType())
+  if (!ParseArguments(info.arguments))
     return false;
 
-  // Parse the name of the method
-  Token nameToken;
-  if(!GetIdentifier(nameToken))
-    throw; // Expected method name
+  // Is default?
+  info.isDefault = false;
+  if (MatchSymbol("="))
+  {
+    Token token;
+    if (!GetToken(token) || token.atom != kAtomDefault)
+      return Error("Expected default");
+
+    info.isDefault = true;
+  }
+
+  FinishDeclaration(info);
+  handler_.Constructor(info);
 
-  writer_.String("name");
-  writer_.String(nameToken.token.c_str());
+  // Skip either the ; or the body of the function
+  Token skipToken;
+  if (!SkipDeclaration(skipToken))
+    return false;
+  return true;
+}
 
-  writer_.String("arguments");
-  writer_.StartArray();
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseArguments(std::vector<ArgumentInfo>& arguments)
+{
+  arguments.clear();
 
   // Start argument list from here
   MatchSymbol("(");
@@ -884,29 +660,29 @@ bool Parser::ParseFunction(Token &token, const std::string& macroName)
     // Walk over all arguments
     do
     {
-      writer_.StartObject();
+      ArgumentInfo argument = ArgumentInfo();
 
       // Get the type of the argument
-      writer_.String("type");
-      if (!ParseType())
+      argument.type = ParseTypeNode();
+      if (argument.type == kNoTypeNode)
         return false;
 
-      // Parse the name of the function
-      writer_.String("name");
+      // Parse the name of the argument
+      Token nameToken;
       if (!GetIdentifier(nameToken))
-        throw; // Expected identifier
-      writer_.String(nameToken.token.c_str());
+        return Error("Missing argument name");
+      argument.name = nameToken.token;
 
       // Parse default value
+      TypeRange defaultValue = { static_cast<uint32_t>(text_.size()), 0 };
       if (MatchSymbol("="))
       {
-        writer_.String("defaultValue");
+        argument.hasDefaultValue = true;
 
-        std::string defaultValue;
         Token token;
         GetToken(token);
         if(token.tokenType == TokenType::kConst)
-          WriteToken(token);
+          argument.defaultValue = token;
         else
         {
           do
@@ -917,39 +693,83 @@ bool Parser::ParseFunction(Token &token, const std::string& macroName)
               UngetToken(token);
               break;
             }
-            defaultValue += token.token;
+            AppendText(defaultValue, token);
           } while (GetToken(token));
-          writer_.String(defaultValue.c_str());
         }
       }
 
-      writer_.EndObject();
+      arguments.push_back(argument);
+      textRanges_.push_back(defaultValue);
     } while (MatchSymbol(",")); // Only in case another is expected
 
     MatchSymbol(")");
   }
 
-  writer_.EndArray();
-  
-  // Optionally parse constness
-  if (MatchIdentifier("const"))
+  // Default values that are not a single constant are stored as text
+  for (std::size_t i = 0; i < arguments.size(); ++i)
+    if (arguments[i].hasDefaultValue && arguments[i].defaultValue.tokenType != TokenType::kConst)
+      arguments[i].defaultValue.token = Text(textRanges_[i]);
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseFunction(Token &token, const std::string& macroName)
+{
+  FunctionInfo& info = function_;
+  StartDeclaration(info, token);
+  info.macro = StringView(macroName.data(), macroName.size());
+
+  if (!ParseComment(info))
+    return false;
+
+  if (!ParseMacroMeta())
+    return false;
+
+  // Process method specifiers in any particular order
+  info.isVirtual = false;
+  info.isInline = false;
+  info.isConstExpr = false;
+  info.isStatic = false;
+  for(bool matched = true; matched;)
   {
-    writer_.String("const");
-    writer_.Bool(true);
+    matched = (!info.isVirtual && (info.isVirtual = MatchIdentifier(kAtomVirtual))) ||
+        (!info.isInline && (info.isInline = MatchIdentifier(kAtomInline))) ||
+        (!info.isConstExpr && (info.isConstExpr = MatchIdentifier(kAtomConstexpr))) ||
+        (!info.isStatic && (info.isStatic = MatchIdentifier(kAtomStatic)));
   }
 
+  // Parse the return type
+  info.returnType = ParseTypeNode();
+  if (info.returnType == kNoTypeNode)
+    return false;
+
+  // Parse the name of the method
+  Token nameToken;
+  if(!GetIdentifier(nameToken))
+    return Error("Missing function name");
+  info.name = nameToken.token;
+
+  if (!ParseArguments(info.arguments))
+    return false;
+  
+  // Optionally parse constness
+  info.isConst = MatchIdentifier(kAtomConst);
+
   // Pure?
+  info.isAbstract = false;
   if (MatchSymbol("="))
   {
     Token token;
     if (!GetToken(token) || token.token != "0")
-      throw; // Expected nothing else than null
+      return Error("Expected 0");
 
-    writer_.String("abstract");
-    writer_.Bool(true);
+    info.isAbstract = true;
   }
 
-  writer_.EndObject();
+  FinishDeclaration(info);
+  handler_.Function(info);
 
   // Skip either the ; or the body of the function
   Token skipToken;
@@ -958,95 +778,96 @@ bool Parser::ParseFunction(Token &token, const std::string& macroName)
   return true;
 }
 
-//-------------------------------------------------------------------------------------------------
-bool Parser::ParseComment()
-{
-  std::string comment = lastComment_.endLine == cursorLine_ ? lastComment_.text : "";
-  if (!comment.empty())
-  {
-    writer_.String("comment");
-    writer_.String(comment.c_str());
-  }
-
-  return true;
-}
-
 //--------------------------------------------------------------------------------------------------
-bool Parser::ParseType()
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseComment(DeclarationInfo& info)
 {
-  std::unique_ptr<TypeNode> node = ParseTypeNode();
-  if (node == nullptr)
-    return false;
-  TypeNodeWriter writer(writer_);
-  writer.VisitNode(*node);
+  // Only build the text of the comment if it directly precedes the current line
+  if (lastComment_.empty() || LineOf(lastComment_.nextPos) != LineOf(tokenPos_))
+    return true;
+
+  CommentText(lastComment_, commentText_);
+  info.comment = StringView(commentText_.data(), commentText_.size());
   return true;
 }
 
 //-------------------------------------------------------------------------------------------------
-std::unique_ptr<TypeNode> Parser::ParseTypeNode()
+template<typename HandlerType>
+uint32_t BasicParser<HandlerType>::ParseTypeNode()
 {
-  std::unique_ptr<TypeNode> node;
+  uint32_t node;
   Token token;
 
   bool isConst = false, isVolatile = false, isMutable = false;
   for (bool matched = true; matched;)
   {
-    matched = (!isConst && (isConst = MatchIdentifier("const"))) ||
-      (!isVolatile && (isVolatile = MatchIdentifier("volatile"))) ||
-      (!isMutable && (isMutable = MatchIdentifier("mutable")));
+    matched = (!isConst && (isConst = MatchIdentifier(kAtomConst))) ||
+      (!isVolatile && (isVolatile = MatchIdentifier(kAtomVolatile))) ||
+      (!isMutable && (isMutable = MatchIdentifier(kAtomMutable)));
   }
 
   // Parse a literal value
-  std::string declarator = ParseTypeNodeDeclarator();
+  TypeRange declarator = ParseTypeNodeDeclarator();
+  if (HasError())
+    return kNoTypeNode;
 
   // Postfix const specifier
-  isConst |= MatchIdentifier("const");
+  isConst |= MatchIdentifier(kAtomConst);
 
   // Template?
   if (MatchSymbol("<"))
   {
-    std::unique_ptr<TemplateNode> templateNode(new TemplateNode(declarator));
+    const std::size_t mark = types_.PendingArguments();
     do
     {
-      auto node = ParseTypeNode();
-      if (node == nullptr)
-        return nullptr;
-      templateNode->arguments.emplace_back(std::move(node));
+      uint32_t argument = ParseTypeNode();
+      if (argument == kNoTypeNode)
+        return kNoTypeNode;
+      types_.PushArgument(TypeRange(), argument);
     } while (MatchSymbol(","));
 
     if (!MatchSymbol(">"))
     {
       Error("Expected closing >");
-      return nullptr;
+      return kNoTypeNode;
     }
 
-    node.reset(templateNode.release());
+    node = types_.AddNode(TypeNode::Type::kTemplate);
+    types_.node(node).named.name = declarator;
+    types_.node(node).named.arguments = types_.PopArguments(mark);
   }
   else
   {
-    node.reset(new LiteralNode(declarator));
+    node = types_.AddNode(TypeNode::Type::kLiteral);
+    types_.node(node).named.name = declarator;
+    types_.node(node).named.arguments = TypeRange();
   }
 
   // Store gathered stuff
-  node->isConst = isConst;
+  types_.node(node).isConst = isConst;
 
   // Check reference or pointer types
   while (GetToken(token))
   {
+    TypeNode::Type type;
     if (token.token == "&")
-      node.reset(new ReferenceNode(std::move(node)));
+      type = TypeNode::Type::kReference;
     else if (token.token == "&&")
-      node.reset(new LReferenceNode(std::move(node)));
+      type = TypeNode::Type::kLReference;
     else if (token.token == "*")
-      node.reset(new PointerNode(std::move(node)));
+      type = TypeNode::Type::kPointer;
     else
     {
       UngetToken(token);
       break;
     }
 
-    if (MatchIdentifier("const"))
-      node->isConst = true;
+    const uint32_t base = node;
+    node = types_.AddNode(type);
+    types_.node(node).base = base;
+
+    if (MatchIdentifier(kAtomConst))
+      types_.node(node).isConst = true;
   }
 
   // Function pointer?
@@ -1060,69 +881,74 @@ std::unique_ptr<TypeNode> Parser::ParseTypeNode()
       Token token;
       GetToken(token);
       if (token.token != ")" || (token.tokenType != TokenType::kIdentifier && !MatchSymbol(")")))
-        throw;
+      {
+        Error("Missing symbol )");
+        return kNoTypeNode;
+      }
     }
 
     // Parse arguments
-    std::unique_ptr<FunctionNode> funcNode(new FunctionNode());
-    funcNode->returns = std::move(node);
-
+    const std::size_t mark = types_.PendingArguments();
     if (!MatchSymbol(")"))
     {
       do
       {
-        std::unique_ptr<FunctionNode::Argument> argument(new FunctionNode::Argument);
-        argument->type = ParseTypeNode();
-        if (argument->type == nullptr)
-          return nullptr;
+        uint32_t argument = ParseTypeNode();
+        if (argument == kNoTypeNode)
+          return kNoTypeNode;
 
         // Get , or name identifier
         if (!GetToken(token))
         {
           Error("Unexpected end of file");
-          return nullptr;
+          return kNoTypeNode;
         }
 
         // Parse optional name
+        TypeRange name = TypeRange();
         if (token.tokenType == TokenType::kIdentifier)
-          argument->name = token.token;
+          name = types_.AddText(token.token.data, token.token.length);
         else
           UngetToken(token);          
 
-        funcNode->arguments.emplace_back(std::move(argument));
+        types_.PushArgument(name, argument);
 
       } while (MatchSymbol(","));
-      if (!MatchSymbol(")"))
-        throw;
+      if (!RequireSymbol(")"))
+        return kNoTypeNode;
     }
 
-    node = std::move(funcNode);
+    const uint32_t returns = node;
+    node = types_.AddNode(TypeNode::Type::kFunction);
+    types_.node(node).function.returns = returns;
+    types_.node(node).function.arguments = types_.PopArguments(mark);
   }
 
   // This stuff refers to the top node
-  node->isVolatile = isVolatile;
-  node->isMutable = isMutable;
+  types_.node(node).isVolatile = isVolatile;
+  types_.node(node).isMutable = isMutable;
 
-  return std::move(node);
+  return node;
 }
 
 //-------------------------------------------------------------------------------------------------
-std::string Parser::ParseTypeNodeDeclarator()
+template<typename HandlerType>
+TypeRange BasicParser<HandlerType>::ParseTypeNodeDeclarator()
 {
   // Skip optional forward declaration specifier
-  MatchIdentifier("class");
-  MatchIdentifier("struct");
-  MatchIdentifier("typename");
+  MatchIdentifier(kAtomClass);
+  MatchIdentifier(kAtomStruct);
+  MatchIdentifier(kAtomTypename);
 
   // Parse a type name 
-  std::string declarator;
+  TypeRange declarator = types_.AddText("", 0);
   Token token;
   bool first = true;
   do
   {
     // Parse the declarator
     if (MatchSymbol("::"))
-      declarator += "::";
+      types_.AppendText(declarator, "::", 2);
     else if (!first)
       break;
 
@@ -1131,9 +957,12 @@ std::string Parser::ParseTypeNodeDeclarator()
 
     // Match an identifier or constant
     if (!GetIdentifier(token) && !GetConst(token))
-      throw; // Expected identifier
+    {
+      Error("Missing identifier");
+      break;
+    }
 
-    declarator += token.token;
+    types_.AppendText(declarator, token.token.data, token.token.length);
 
   } while (true);
 
@@ -1141,107 +970,62 @@ std::string Parser::ParseTypeNodeDeclarator()
 }
 
 //-------------------------------------------------------------------------------------------------
-std::string Parser::ParseTypename()
+template<typename HandlerType>
+std::string BasicParser<HandlerType>::ParseTypename()
 {
   return "";
 }
 
-//----------------------------------------------------------------------------------------------------------------------
-void Parser::WriteToken(const Token &token)
-{
-  if(token.tokenType == TokenType::kConst)
-  {
-    switch(token.constType)
-    {
-    case ConstType::kBoolean:
-      writer_.Bool(token.boolConst);
-      break;
-    case ConstType::kUInt32:
-      writer_.Uint(token.uint32Const);
-      break;
-    case ConstType::kInt32:
-      writer_.Int(token.int32Const);
-      break;
-    case ConstType::kUInt64:
-      writer_.Uint64(token.uint64Const);
-      break;
-    case ConstType::kInt64:
-      writer_.Int64(token.int64Const);
-      break;
-    case ConstType::kReal:
-      writer_.Double(token.realConst);
-      break;
-    case ConstType::kString:
-      //writer_.String((std::string("\"") + token.stringConst + "\"").c_str());
-      writer_.String(token.stringConst.c_str());
-      break;
-    }
-  }
-  else
-    writer_.String(token.token.c_str());
-}
-
-//-------------------------------------------------------------------------------------------------
-bool Parser::ParseCustomMacro(Token & token, const std::string& macroName)
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseCustomMacro(Token & token, const std::string& macroName)
 {
-  writer_.StartObject();
-  writer_.String("type");
-  writer_.String("macro");
-  writer_.String("name");
-  writer_.String(macroName.c_str());
-  writer_.String("line");
-  writer_.Uint((unsigned) token.startLine);
-
-  WriteCurrentAccessControlType();
+  MacroInfo& info = macro_;
+  StartDeclaration(info, token);
+  info.name = StringView(macroName.data(), macroName.size());
 
   if (!ParseMacroMeta())
     return false;
 
-  writer_.EndObject();
+  FinishDeclaration(info);
+  handler_.Macro(info);
   return true;
 }
 
-//-------------------------------------------------------------------------------------------------
-bool Parser::ParseClassTemplate()
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseClassTemplate(ClassInfo& info)
 {
-  writer_.String("template");
-  writer_.StartObject();
+  info.isTemplate = true;
 
   if(!RequireSymbol("<"))
     return false;
 
-  writer_.String("arguments");
-  writer_.StartArray();
-
   do
   {
-    if(!ParseClassTemplateArgument())
+    if(!ParseClassTemplateArgument(info))
       return false;
   } while(MatchSymbol(","));
 
-  writer_.EndArray();
-
   if(!RequireSymbol(">"))
     return false;
-  writer_.EndObject();
 
   return true;
 }
 
-//-------------------------------------------------------------------------------------------------
-bool Parser::ParseClassTemplateArgument()
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+bool BasicParser<HandlerType>::ParseClassTemplateArgument(ClassInfo& info)
 {
-  writer_.StartObject();
+  TemplateArgumentInfo argument;
 
   Token token;
-  if(!GetToken(token) || token.tokenType != TokenType::kIdentifier || !(token.token == "class" || token.token == "typename"))
+  if(!GetToken(token) || token.tokenType != TokenType::kIdentifier || !(token.atom == kAtomClass || token.atom == kAtomTypename))
   {
     Error("expected either 'class' or 'identifier' in template argument");
     return false;
   }
-
-  writer_.String("typeParameterKey");
-  writer_.String(token.token.c_str());
+  argument.typeParameterKey = token.token;
 
   // Parse the name
   GetToken(token);
@@ -1250,18 +1034,122 @@ bool Parser::ParseClassTemplateArgument()
     Error("expected identifier");
     return false;
   }
-
-  writer_.String("name");
-  writer_.String(token.token.c_str());
+  argument.name = token.token;
 
   // Optionally check if there is a default initializer
+  argument.defaultType = kNoTypeNode;
   if(MatchSymbol("="))
   {
-    writer_.String("defaultType");
-    if(!ParseType())
+    argument.defaultType = ParseTypeNode();
+    if (argument.defaultType == kNoTypeNode)
       return false;
   }
 
-  writer_.EndObject();
+  info.templateArguments.push_back(argument);
   return true;
 }
+
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::StartDeclaration(DeclarationInfo& info, const Token& token)
+{
+  info.line = LineOf(token.startPos);
+
+  // Access is only reported for members of classes
+  info.isMember = topScope_->type == ScopeType::kClass;
+  info.access = current_access_control_type();
+
+  info.comment = StringView();
+  info.meta = nullptr;
+  info.metaCount = 0;
+  info.types = &types_;
+
+  types_.Clear();
+  meta_.clear();
+  text_.clear();
+  textRanges_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::FinishDeclaration(DeclarationInfo& info)
+{
+  info.meta = meta_.data();
+  info.metaCount = meta_.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename HandlerType>
+void BasicParser<HandlerType>::AppendText(TypeRange& range, const Token& token)
+{
+  text_.append(token.token.data, token.token.length);
+  range.count += static_cast<uint32_t>(token.token.length);
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+OutputParser<OutputHandler>::OutputParser(const Options &options) :
+  handler_(options),
+  parser_(options, handler_)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+void OutputParser<OutputHandler>::Reset()
+{
+  parser_.Reset();
+  handler_.Reset();
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+bool OutputParser<OutputHandler>::Parse(const char *input)
+{
+  return Parse(input, std::char_traits<char>::length(input));
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+bool OutputParser<OutputHandler>::Parse(const char *input, std::size_t length)
+{
+  handler_.Reset();
+  handler_.StartDocument();
+  if (!parser_.Parse(input, length))
+    return false;
+
+  handler_.EndDocument();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+bool OutputParser<OutputHandler>::Parse(const char *input, std::size_t length, std::string& output)
+{
+  if (!Parse(input, length))
+    return false;
+
+  output.append(handler_.output().data(), handler_.output().size());
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+template<typename OutputHandler>
+bool OutputParser<OutputHandler>::Parse(const char *input, std::size_t length, int fd)
+{
+  handler_.output().Open(fd);
+  const bool result = Parse(input, length);
+  handler_.output().Open(-1);
+  return result && !handler_.output().failed();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The handlers that can be selected
+template class BasicParser<Handler>;
+template class BasicParser<JsonHandler<rapidjson::PrettyWriter<OutputStream>>>;
+template class BasicParser<JsonHandler<rapidjson::Writer<OutputStream>>>;
+template class BasicParser<BinaryHandler>;
+template class OutputParser<JsonHandler<rapidjson::PrettyWriter<OutputStream>>>;
+template class OutputParser<JsonHandler<rapidjson::Writer<OutputStream>>>;
+template class OutputParser<BinaryHandler>;
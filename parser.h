@@ -1,11 +1,17 @@
 #pragma once
 
+#include "annotation_filter.h"
 #include "tokenizer.h"
+#include "token.h"
+#include "binary_handler.h"
+#include "handler.h"
+#include "json_handler.h"
 #include "options.h"
+#include "output_stream.h"
 #include "type_node.h"
 #include <string>
 #include <rapidjson/prettywriter.h>
-#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 enum class ScopeType
 {
@@ -14,28 +20,41 @@ enum class ScopeType
   kClass
 };
 
-enum class AccessControlType 
-{
-  kPublic,
-  kPrivate,
-  kProtected
-};
-
-class Parser : private Tokenizer
+/**
+ * @brief Parses the annotated declarations of a header and reports them to a handler.
+ * @details The parser is a template over the handler. Instantiated for Handler the declarations are
+ * reported through virtual calls, instantiated for the output handlers all calls are resolved at
+ * compile time. It is instantiated for those handlers in parser.cc.
+ */
+template<typename HandlerType>
+class BasicParser : private Tokenizer
 {
 public:
-  Parser(const Options& options);
-  virtual ~Parser();
+  BasicParser(const Options& options, HandlerType& handler);
+  virtual ~BasicParser();
 
   // No copying of parser
-  Parser(const Parser& other) = delete;
-  Parser(Parser&& other) = delete;
-
-  // Parses the given input
+  BasicParser(const BasicParser& other) = delete;
+  BasicParser(BasicParser&& other) = delete;
+
+  /**
+   * @brief Discards the state of a previous parse.
+   * @details Allocated memory is kept for the next parse, as are the interned identifiers. A parser
+   * that is reused for many inputs therefore stops allocating once it has seen the largest input and
+   * the common identifiers. Only the type tree is freed if an unusually large type grew it beyond a
+   * limit, and the identifiers but the annotation macros are dropped once there are too many of them,
+   * so a parser that lives long does not keep every identifier it has seen. Parse calls this itself.
+   */
+  void Reset();
+
+  // Parses the given NUL terminated input
   bool Parse(const char* input);
 
-  /// Returns the result of a previous parse
-  std::string result() const { return std::string(buffer_.GetString(), buffer_.GetString() + buffer_.GetSize()); }
+  // Parses the given input of the given length
+  bool Parse(const char* input, std::size_t length);
+
+  /// Returns the error of the last parse that failed, see Tokenizer::error
+  using Tokenizer::error;
 
 protected:
   /// Called to parse the next statement. Returns false if there are no more statements.
@@ -48,49 +67,171 @@ protected:
   bool ParseMacroMeta();
   bool ParseMetaSequence();
 
-  void PushScope(const std::string& name, ScopeType scopeType, AccessControlType accessControlType);
-  void PopScope();
+  bool PushScope(Atom name, ScopeType scopeType, AccessControlType accessControlType);
+  bool PopScope();
 
   bool ParseNamespace();
   bool ParseAccessControl(const Token& token, AccessControlType& type);
 
   AccessControlType current_access_control_type() const { return topScope_->currentAccessControlType; }
-  void WriteCurrentAccessControlType();
 
-  void WriteAccessControlType(AccessControlType type);
   bool ParseClass(Token &token);
-  bool ParseClassTemplate();
+  bool ParseClassTemplate(ClassInfo& info);
   bool ParseFunction(Token &token, const std::string& macroName);
   bool ParseConstructor(Token& token);
+  bool ParseArguments(std::vector<ArgumentInfo>& arguments);
 
-  bool ParseComment();
-
-  bool ParseType();
+  bool ParseComment(DeclarationInfo& info);
 
-  std::unique_ptr<TypeNode> ParseTypeNode();
-  std::string ParseTypeNodeDeclarator();
+  /// Parses a type into types_ and returns the index of its root node, or kNoTypeNode
+  uint32_t ParseTypeNode();
+  TypeRange ParseTypeNodeDeclarator();
 
   std::string ParseTypename();
 
-  void WriteToken(const Token &token);
   bool ParseCustomMacro(Token & token, const std::string& macroName);
 
+  /// Starts the info of the declaration at the given token, and the declaration text and types
+  void StartDeclaration(DeclarationInfo& info, const Token& token);
+
+  /// Points the info at the arguments of the annotation macro once they are complete
+  void FinishDeclaration(DeclarationInfo& info);
+
+  /// Appends the text of a token to the declaration text
+  void AppendText(TypeRange& range, const Token& token);
+
+  /// Returns a range of the declaration text. The text is only valid until the next call to AppendText.
+  StringView Text(const TypeRange& range) const { return StringView(text_.data() + range.first, range.count); }
+
 private:
   Options options_;
-  rapidjson::StringBuffer buffer_;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer_;
+  HandlerType& handler_;
+
+  /// The kinds of declarations that are recognized by their first identifier
+  enum class DeclarationType : uint8_t
+  {
+    kNone,
+    kEnum,
+    kClass,
+    kFunction,
+    kConstructor,
+    kProperty,
+    kNamespace,
+    kAccessControl,
+    kCustomMacro
+  };
+
+  struct Declaration
+  {
+    DeclarationType type;
+
+    /// Index of the macro name in options_.functionNameMacro or options_.customMacros
+    uint32_t macro;
+  };
+
+  /// Registers the declaration that starts with the given identifier, unless one is registered already
+  void AddDeclaration(Atom atom, DeclarationType type, uint32_t macro = 0);
+  void AddDeclaration(const std::string& macroName, DeclarationType type, uint32_t macro = 0);
+
+  /// The declarations indexed by the atom of their first identifier, built from options_
+  std::vector<Declaration> declarations_;
+
+  /// Number of atoms once the declarations are interned, Reset keeps these
+  std::size_t declarationAtomCount_;
+
+  /// Finds the macro names and scope keywords in the input before it is tokenized
+  AnnotationFilter filter_;
+  std::vector<std::size_t> landmarkPositions_;
+  std::vector<Landmark> landmarks_;
 
   struct Scope
   {
     ScopeType type;
-    std::string name;
+    Atom name;
     AccessControlType currentAccessControlType;
   };
 
+  /// The nodes of the types of the declaration that is being parsed
+  TypeTree types_;
+
+  /// The arguments of the annotation macro of the declaration that is being parsed
+  std::vector<MetaEntry> meta_;
+
+  /// The text of the initializers of the declaration that is being parsed
+  std::string text_;
+
+  /// Ranges of text_ that are turned into views once the declaration is complete
+  std::vector<TypeRange> textRanges_;
+
+  /// The info of the declarations, reused so their arrays keep their capacity
+  ClassInfo class_;
+  EnumInfo enum_;
+  PropertyInfo property_;
+  FunctionInfo function_;
+  ConstructorInfo constructor_;
+  MacroInfo macro_;
+
+  /// The text of the last comment
+  std::string commentText_;
+
   Scope scopes_[64];
   Scope *topScope_;
 
-    bool ParseClassTemplateArgument();
+    bool ParseClassTemplateArgument(ClassInfo& info);
+};
+
+/**
+ * @brief Parses the annotated declarations of a header and writes them to an OutputStream.
+ * @details The parser is a template over the handler that writes the output, so the choice of the
+ * output format is made at compile time. It is instantiated for the handlers in parser.cc; use the
+ * Parser, CompactParser and BinaryParser typedefs.
+ */
+template<typename OutputHandler>
+class OutputParser
+{
+public:
+  OutputParser(const Options& options);
+
+  // No copying of parser
+  OutputParser(const OutputParser& other) = delete;
+  OutputParser(OutputParser&& other) = delete;
+
+  /// Discards the result and state of a previous parse, see BasicParser::Reset
+  void Reset();
+
+  // Parses the given NUL terminated input
+  bool Parse(const char* input);
+
+  // Parses the given input of the given length
+  bool Parse(const char* input, std::size_t length);
+
+  /// Parses the given input and appends the result to output if parsing succeeds
+  bool Parse(const char* input, std::size_t length, std::string& output);
+
+  /**
+   * @brief Parses the given input and writes the result to the given file descriptor.
+   * @details The declarations are written while they are parsed, so the memory used does not depend
+   * on the size of the output. If parsing fails the output written so far is incomplete. Returns false
+   * if parsing or writing fails.
+   */
+  bool Parse(const char* input, std::size_t length, int fd);
+
+  /// Returns the error of the last parse that failed as "line:column: message"
+  const char* error() const { return parser_.error(); }
+
+  /// Returns the result of a previous parse, empty if the result was written to a file descriptor
+  std::string result() const { return std::string(handler_.output().data(), handler_.output().size()); }
+
+private:
+  OutputHandler handler_;
+  BasicParser<OutputHandler> parser_;
 };
 
+/// Parser that writes indented json
+typedef OutputParser<JsonHandler<rapidjson::PrettyWriter<OutputStream>>> Parser;
+
+/// Parser that writes json without any white space
+typedef OutputParser<JsonHandler<rapidjson::Writer<OutputStream>>> CompactParser;
 
+/// Parser that writes the binary format of binary_format.h
+typedef OutputParser<BinaryHandler> BinaryParser;
@@ -0,0 +1,432 @@
+#include "result_cache.h"
+#include "binary_format.h"
+#include "input_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <process.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  /// Marks the start of an entry, "HPRC"
+  const uint32_t kEntryMagic = 0x43525048;
+
+  /// An entry starts with the magic, the version, the options hash, the input hash, the input size and
+  /// the output size, followed by the output
+  const std::size_t kEntryHeaderSize = 2 * sizeof(uint32_t) + 4 * sizeof(uint64_t);
+
+  /// Length of the name of an entry: the input hash and the options hash in hexadecimal
+  const std::size_t kEntryNameLength = 32;
+
+  /// Temporary files left behind by processes that did not finish are removed after this many seconds
+  const std::time_t kTemporaryFileAge = 60 * 60;
+
+  const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+  const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+  const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+  //------------------------------------------------------------------------------------------------
+  uint64_t RotateLeft(uint64_t value, int count)
+  {
+    return (value << count) | (value >> (64 - count));
+  }
+
+  //------------------------------------------------------------------------------------------------
+  uint64_t Read64(const char* data)
+  {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  uint32_t Read32(const char* data)
+  {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  uint64_t Round(uint64_t accumulator, uint64_t input)
+  {
+    accumulator += input * kPrime2;
+    return RotateLeft(accumulator, 31) * kPrime1;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+  {
+    accumulator ^= Round(0, value);
+    return accumulator * kPrime1 + kPrime4;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /// XXH64 of the given data. Words are read in the byte order of the machine, which is fine for a
+  /// cache that is not shared between machines.
+  uint64_t Hash(const char* data, std::size_t size, uint64_t seed)
+  {
+    const char* end = data + size;
+    uint64_t hash;
+    if (size >= 32)
+    {
+      uint64_t v1 = seed + kPrime1 + kPrime2;
+      uint64_t v2 = seed + kPrime2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - kPrime1;
+      for (; end - data >= 32; data += 32)
+      {
+        v1 = Round(v1, Read64(data));
+        v2 = Round(v2, Read64(data + 8));
+        v3 = Round(v3, Read64(data + 16));
+        v4 = Round(v4, Read64(data + 24));
+      }
+
+      hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+      hash = MergeRound(hash, v1);
+      hash = MergeRound(hash, v2);
+      hash = MergeRound(hash, v3);
+      hash = MergeRound(hash, v4);
+    }
+    else
+      hash = seed + kPrime5;
+
+    hash += static_cast<uint64_t>(size);
+    for (; end - data >= 8; data += 8)
+      hash = RotateLeft(hash ^ Round(0, Read64(data)), 27) * kPrime1 + kPrime4;
+    if (end - data >= 4)
+    {
+      hash = RotateLeft(hash ^ (Read32(data) * kPrime1), 23) * kPrime2 + kPrime3;
+      data += 4;
+    }
+    for (; data != end; ++data)
+      hash = RotateLeft(hash ^ (static_cast<unsigned char>(*data) * kPrime5), 11) * kPrime1;
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /// Appends a string to a key, preceded by its length so consecutive strings cannot run into each other
+  void AppendKey(std::string& key, const std::string& text)
+  {
+    const uint64_t length = text.size();
+    key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    key += text;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  void AppendHex(std::string& text, uint64_t value)
+  {
+    static const char kHexDigits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4)
+      text += kHexDigits[(value >> shift) & 0xf];
+  }
+
+  //------------------------------------------------------------------------------------------------
+  std::string JoinPath(const std::string& directory, const std::string& name)
+  {
+    if (directory.back() == '/' || directory.back() == '\\')
+      return directory + name;
+    return directory + '/' + name;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  bool IsEntryName(const char* name)
+  {
+    std::size_t length = 0;
+    for (; name[length] != '\0'; ++length)
+    {
+      if (!((name[length] >= '0' && name[length] <= '9') || (name[length] >= 'a' && name[length] <= 'f')))
+        return false;
+    }
+    return length == kEntryNameLength;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  bool IsTemporaryName(const char* name)
+  {
+    const std::size_t length = std::strlen(name);
+    return length > 4 && std::strcmp(name + length - 4, ".tmp") == 0;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /// Writes all of the given data to a file descriptor
+  bool WriteAll(int fd, const char* data, std::size_t size)
+  {
+    while (size > 0)
+    {
+#ifdef _WIN32
+      int written = _write(fd, data, static_cast<unsigned>(std::min<std::size_t>(size, 1 << 30)));
+#else
+      ssize_t written = write(fd, data, size);
+#endif
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+
+      data += written;
+      size -= static_cast<std::size_t>(written);
+    }
+    return true;
+  }
+
+  /// A file in the cache directory
+  struct CacheFile
+  {
+    std::string name;
+    uint64_t size;
+    std::time_t modified;
+  };
+
+  //------------------------------------------------------------------------------------------------
+  /// Lists the entries and temporary files in the given directory
+  bool ListFiles(const std::string& directory, std::vector<CacheFile>& files)
+  {
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(JoinPath(directory, "*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+      return false;
+
+    do
+    {
+      if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 || (!IsEntryName(entry.cFileName) && !IsTemporaryName(entry.cFileName)))
+        continue;
+
+      // FILETIME counts 100 nanoseconds since 1601, time_t seconds since 1970
+      const uint64_t size = (static_cast<uint64_t>(entry.nFileSizeHigh) << 32) | entry.nFileSizeLow;
+      const uint64_t time = (static_cast<uint64_t>(entry.ftLastWriteTime.dwHighDateTime) << 32) | entry.ftLastWriteTime.dwLowDateTime;
+      files.push_back({ entry.cFileName, size, static_cast<std::time_t>(time / 10000000 - 11644473600ull) });
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr)
+      return false;
+
+    while (struct dirent* entry = readdir(dir))
+    {
+      if (!IsEntryName(entry->d_name) && !IsTemporaryName(entry->d_name))
+        continue;
+
+      struct stat st;
+      if (stat(JoinPath(directory, entry->d_name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        files.push_back({ entry->d_name, static_cast<uint64_t>(st.st_size), st.st_mtime });
+    }
+    closedir(dir);
+#endif
+    return true;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+ResultCache::ResultCache() :
+  maxSize_(0),
+  optionsHash_(0),
+  stored_(0),
+  temporaryCount_(0)
+{
+
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ResultCache::Open(const std::string& directory, uint64_t maxSize, const Options& options)
+{
+#ifdef _WIN32
+  DWORD attributes = GetFileAttributesA(directory.c_str());
+  if (attributes == INVALID_FILE_ATTRIBUTES || (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+    return false;
+#else
+  struct stat st;
+  if (stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || access(directory.c_str(), R_OK | W_OK | X_OK) != 0)
+    return false;
+#endif
+
+  directory_ = directory;
+  maxSize_ = maxSize;
+
+  // Everything that changes the output for the same input
+  std::string key;
+  const uint32_t versions[] = { kResultCacheVersion, kBinaryVersion };
+  key.append(reinterpret_cast<const char*>(versions), sizeof(versions));
+  AppendKey(key, options.classNameMacro);
+  AppendKey(key, options.enumNameMacro);
+  AppendKey(key, options.propertyNameMacro);
+  AppendKey(key, options.constructorNameMacro);
+  AppendKey(key, std::to_string(options.functionNameMacro.size()));
+  for (const std::string& macro : options.functionNameMacro)
+    AppendKey(key, macro);
+  AppendKey(key, std::to_string(options.customMacros.size()));
+  for (const std::string& macro : options.customMacros)
+    AppendKey(key, macro);
+  key += options.typeTable ? 't' : '-';
+  key += options.compact ? 'c' : '-';
+  key += options.binary ? 'b' : '-';
+  optionsHash_ = Hash(key.data(), key.size(), 0);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+std::string ResultCache::EntryPath(const char* input, std::size_t size, uint64_t& hash) const
+{
+  hash = Hash(input, size, optionsHash_);
+
+  std::string name;
+  AppendHex(name, hash);
+  AppendHex(name, optionsHash_);
+  return JoinPath(directory_, name);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ResultCache::Load(const char* input, std::size_t size, std::string& output)
+{
+  uint64_t hash;
+  const std::string path = EntryPath(input, size, hash);
+
+  InputFile entry;
+  if (!entry.Open(path) || entry.size() < kEntryHeaderSize)
+    return false;
+
+  // Check the whole key, the name only holds the hashes
+  const char* data = entry.data();
+  const uint64_t outputSize = Read64(data + 32);
+  if (Read32(data) != kEntryMagic || Read32(data + 4) != kResultCacheVersion || Read64(data + 8) != optionsHash_ ||
+      Read64(data + 16) != hash || Read64(data + 24) != size || outputSize != entry.size() - kEntryHeaderSize)
+    return false;
+
+  output.append(data + kEntryHeaderSize, static_cast<std::size_t>(outputSize));
+
+  // Mark the entry as recently used
+#ifdef _WIN32
+  _utime(path.c_str(), nullptr);
+#else
+  utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+#endif
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void ResultCache::Store(const char* input, std::size_t size, const std::string& output)
+{
+  uint64_t hash;
+  const std::string path = EntryPath(input, size, hash);
+
+  char header[kEntryHeaderSize];
+  const uint32_t magic[] = { kEntryMagic, kResultCacheVersion };
+  const uint64_t key[] = { optionsHash_, hash, static_cast<uint64_t>(size), static_cast<uint64_t>(output.size()) };
+  std::memcpy(header, magic, sizeof(magic));
+  std::memcpy(header + sizeof(magic), key, sizeof(key));
+
+  // Write to a file of this process and thread first, renaming it is atomic
+#ifdef _WIN32
+  const int process = _getpid();
+#else
+  const int process = static_cast<int>(getpid());
+#endif
+  const std::string temporaryPath = path + '.' + std::to_string(process) + '.' + std::to_string(temporaryCount_++) + ".tmp";
+#ifdef _WIN32
+  int fd = _open(temporaryPath.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+#endif
+  if (fd < 0)
+    return;
+
+  bool written = WriteAll(fd, header, sizeof(header)) && WriteAll(fd, output.data(), output.size());
+#ifdef _WIN32
+  written = _close(fd) == 0 && written;
+  written = written && MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  written = close(fd) == 0 && written;
+  written = written && rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+  if (!written)
+  {
+    std::remove(temporaryPath.c_str());
+    return;
+  }
+
+  stored_ += sizeof(header) + output.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+void ResultCache::Trim()
+{
+  // Another process that is trimming holds the lock, it removes the entries of this one as well
+  const std::string lockPath = JoinPath(directory_, "lock");
+#ifdef _WIN32
+  HANDLE lock = CreateFileA(lockPath.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (lock == INVALID_HANDLE_VALUE)
+    return;
+#else
+  int lock = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (lock < 0)
+    return;
+  if (flock(lock, LOCK_EX | LOCK_NB) != 0)
+  {
+    close(lock);
+    return;
+  }
+#endif
+
+  std::vector<CacheFile> files;
+  if (ListFiles(directory_, files))
+  {
+    const std::time_t now = std::time(nullptr);
+    uint64_t size = 0;
+    for (const CacheFile& file : files)
+    {
+      if (IsEntryName(file.name.c_str()))
+        size += file.size;
+      else if (IsTemporaryName(file.name.c_str()) && now - file.modified > kTemporaryFileAge)
+        std::remove(JoinPath(directory_, file.name).c_str());
+    }
+
+    if (size > maxSize_)
+    {
+      std::stable_sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.modified < b.modified; });
+
+      const uint64_t target = maxSize_ / 4 * 3;
+      for (const CacheFile& file : files)
+      {
+        if (size <= target)
+          break;
+        if (IsEntryName(file.name.c_str()) && std::remove(JoinPath(directory_, file.name).c_str()) == 0)
+          size -= file.size;
+      }
+    }
+  }
+
+#ifdef _WIN32
+  CloseHandle(lock);
+#else
+  close(lock);
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "options.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Bump when the output for the same input and options changes, so results of older versions are not used
+static const uint32_t kResultCacheVersion = 1;
+
+/**
+ * @brief Stores the output of parsed files on disk, so files that did not change are not parsed again.
+ * @details An entry is keyed on a 64 bit xxHash of the contents of a file, seeded with a hash of the
+ * options that affect the output and kResultCacheVersion. Every entry is a file in the cache directory,
+ * written to a temporary file first and renamed into place, so processes that share the directory
+ * never see a partial entry. Reading an entry marks it as used by updating its modification time.
+ *
+ * Once the entries exceed the size of the cache, Trim removes the least recently used ones until the
+ * cache is three quarters full. Only one process trims at a time, and files of other processes that
+ * are in use stay readable while they are removed. The cache is best effort: entries that cannot be
+ * read are ignored and entries that cannot be written are skipped.
+ *
+ * Load and Store may be called from several threads at the same time.
+ */
+class ResultCache
+{
+public:
+  ResultCache();
+
+  // Do not allow copy or move
+  ResultCache(const ResultCache& other) = delete;
+  ResultCache(ResultCache&& other) = delete;
+
+  /// Uses the given existing directory for the output of files parsed with the given options, holding
+  /// up to maxSize bytes. Returns false if the directory cannot be used.
+  bool Open(const std::string& directory, uint64_t maxSize, const Options& options);
+
+  /// Appends the stored output for the given input to output, returns false if there is none
+  bool Load(const char* input, std::size_t size, std::string& output);
+
+  /// Stores the output for the given input
+  void Store(const char* input, std::size_t size, const std::string& output);
+
+  /// Removes the least recently used entries if the cache is larger than its size
+  void Trim();
+
+  /// Returns the number of bytes stored since the cache was opened
+  uint64_t stored() const { return stored_; }
+
+private:
+  /// Returns the path of the entry of the given input, and its hash
+  std::string EntryPath(const char* input, std::size_t size, uint64_t& hash) const;
+
+private:
+  std::string directory_;
+  uint64_t maxSize_;
+  uint64_t optionsHash_;
+
+  std::atomic<uint64_t> stored_;
+
+  /// Makes the names of temporary files of this process unique
+  std::atomic<uint32_t> temporaryCount_;
+};
@@ -0,0 +1,122 @@
+#include "task_scheduler.h"
+#include <algorithm>
+#include <numeric>
+
+//--------------------------------------------------------------------------------------------------
+TaskScheduler::TaskScheduler(unsigned threadCount, const std::vector<uint64_t>& costs, Task task) :
+  task_(std::move(task)),
+  costs_(costs)
+{
+  threadCount = std::max(1u, threadCount);
+  for (unsigned i = 0; i < threadCount; ++i)
+  {
+    queues_.emplace_back(new Queue);
+    queues_.back()->size = 0;
+    queues_.back()->cost = 0;
+  }
+
+  // Deal the tasks from the most expensive down, each to the queue with the lowest total cost. Equal
+  // costs keep the order of the tasks.
+  std::vector<std::size_t> order(costs.size());
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  std::stable_sort(order.begin(), order.end(), [&costs](std::size_t a, std::size_t b) { return costs[a] > costs[b]; });
+
+  std::vector<uint64_t> totals(threadCount, 0);
+  for (std::size_t index : order)
+  {
+    const std::size_t worker = std::min_element(totals.begin(), totals.end()) - totals.begin();
+    totals[worker] += costs[index];
+    queues_[worker]->tasks.push_back(index);
+  }
+  for (unsigned i = 0; i < threadCount; ++i)
+  {
+    queues_[i]->size = queues_[i]->tasks.size();
+    queues_[i]->cost = totals[i];
+  }
+
+  for (unsigned i = 0; i < threadCount; ++i)
+    threads_.emplace_back(&TaskScheduler::Run, this, i);
+}
+
+//--------------------------------------------------------------------------------------------------
+TaskScheduler::~TaskScheduler()
+{
+  Wait();
+}
+
+//--------------------------------------------------------------------------------------------------
+void TaskScheduler::Wait()
+{
+  for (std::thread& thread : threads_)
+    thread.join();
+  threads_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+void TaskScheduler::Run(unsigned worker)
+{
+  std::size_t task;
+  while (Pop(worker, task) || Steal(worker, task))
+    task_(worker, task);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool TaskScheduler::Pop(unsigned worker, std::size_t& task)
+{
+  Queue& queue = *queues_[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+
+  Take(queue, task, true);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool TaskScheduler::Steal(unsigned worker, std::size_t& task)
+{
+  // No tasks are added once the threads run, so there is nothing left once all queues are empty
+  for (;;)
+  {
+    Queue* victim = nullptr;
+    uint64_t victimCost = 0;
+    for (std::size_t i = 0; i < queues_.size(); ++i)
+    {
+      Queue& queue = *queues_[i];
+      const uint64_t cost = queue.cost.load(std::memory_order_relaxed);
+      if (i != worker && queue.size.load(std::memory_order_relaxed) != 0 && (victim == nullptr || cost > victimCost))
+      {
+        victim = &queue;
+        victimCost = cost;
+      }
+    }
+
+    if (victim == nullptr)
+      return false;
+
+    // The victim may have emptied its queue in the meantime, look again if it did
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->tasks.empty())
+    {
+      Take(*victim, task, false);
+      return true;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void TaskScheduler::Take(Queue& queue, std::size_t& task, bool front)
+{
+  if (front)
+  {
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+  }
+  else
+  {
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+  }
+  queue.size.store(queue.tasks.size(), std::memory_order_relaxed);
+  queue.cost.store(queue.cost.load(std::memory_order_relaxed) - costs_[task], std::memory_order_relaxed);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs independent tasks on a number of threads, the most expensive ones first.
+ * @details Every task comes with a cost, an estimate of its run time. The tasks are dealt to the
+ * threads in order of decreasing cost, each to the thread with the least work so far, so the largest
+ * tasks start right away and the small ones fill up the tail. A thread runs its own tasks from the
+ * largest down. Once it runs out it steals the smallest task of the thread with the most work left, so
+ * no thread idles while a few large tasks are still queued behind each other.
+ */
+class TaskScheduler
+{
+public:
+  /// Runs the task with the given index, on the worker thread with the given index
+  typedef std::function<void(unsigned worker, std::size_t task)> Task;
+
+  /// Starts running task for every index of costs on the given number of threads
+  TaskScheduler(unsigned threadCount, const std::vector<uint64_t>& costs, Task task);
+
+  /// Waits for all tasks to complete
+  ~TaskScheduler();
+
+  // Do not allow copy or move
+  TaskScheduler(const TaskScheduler& other) = delete;
+  TaskScheduler(TaskScheduler&& other) = delete;
+
+  /// Waits for all tasks to complete
+  void Wait();
+
+private:
+  /// The tasks of a worker thread, in order of decreasing cost
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+
+    /// The number and the total cost of the queued tasks, to pick a thread to steal from without locking
+    std::atomic<std::size_t> size;
+    std::atomic<uint64_t> cost;
+  };
+
+  void Run(unsigned worker);
+
+  /// Takes the next task from the queue of the given worker
+  bool Pop(unsigned worker, std::size_t& task);
+
+  /// Takes a task from the queue of another worker
+  bool Steal(unsigned worker, std::size_t& task);
+
+  /// Removes the task at the front or back of a locked queue
+  void Take(Queue& queue, std::size_t& task, bool front);
+
+private:
+  Task task_;
+  std::vector<uint64_t> costs_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+};
@@ -0,0 +1,35 @@
+#include "test.h"
+#include "atom_table.h"
+
+//--------------------------------------------------------------------------------------------------
+TEST(AtomTableTruncate)
+{
+  AtomTable atoms;
+  const Atom macro = atoms.Intern("TCLASS");
+  const std::size_t kept = atoms.size();
+  const char* macroName = atoms.Name(macro).data;
+
+  // Enough names to fill several chunks and grow the hash slots
+  for (int i = 0; i < 20000; ++i)
+    atoms.Intern("identifier" + std::to_string(i));
+  EXPECT_EQ(kept + 20000, atoms.size());
+
+  atoms.Truncate(kept);
+  EXPECT_EQ(kept, atoms.size());
+  EXPECT_EQ(macro, atoms.Intern("TCLASS"));
+  EXPECT(atoms.Name(macro).data == macroName);
+  EXPECT_EQ(std::string("TCLASS"), atoms.Name(macro).str());
+  EXPECT_EQ(static_cast<Atom>(kAtomNamespace), atoms.Intern("namespace"));
+
+  // Removed names are interned again as new atoms
+  const Atom atom = atoms.Intern("identifier7");
+  EXPECT_EQ(static_cast<Atom>(kept), atom);
+  EXPECT_EQ(std::string("identifier7"), atoms.Name(atom).str());
+  EXPECT_EQ(std::string("TCLASS"), atoms.Name(macro).str());
+
+  // Truncating below the predefined atoms keeps them
+  atoms.Truncate(0);
+  EXPECT_EQ(static_cast<std::size_t>(kPredefinedAtomCount), atoms.size());
+  EXPECT_EQ(static_cast<Atom>(kAtomDefault), atoms.Intern("default"));
+  EXPECT_EQ(static_cast<Atom>(kPredefinedAtomCount), atoms.Intern("TCLASS"));
+}
@@ -0,0 +1,489 @@
+#include "test.h"
+#include "binary_reader.h"
+#include "parser.h"
+#include <fstream>
+#include <iterator>
+#include <rapidjson/prettywriter.h>
+
+namespace {
+  typedef rapidjson::PrettyWriter<OutputStream> JsonWriter;
+
+  /**
+   * @brief Writes the declarations of a binary file as json, the way Parser writes them.
+   * @details Everything is read through BinaryReader, so comparing the result with the output of
+   * Parser checks that every declaration and type tree written by BinaryParser reads back intact.
+   */
+  class BinaryJsonWriter
+  {
+  public:
+    BinaryJsonWriter(const BinaryReader& reader, OutputStream& stream) :
+      reader_(reader),
+      writer_(stream)
+    {
+
+    }
+
+    void Write()
+    {
+      WriteDeclarations(0, reader_.declarationCount());
+    }
+
+  private:
+    void WriteString(const BinaryString& text)
+    {
+      writer_.String(text.data, static_cast<rapidjson::SizeType>(text.length));
+    }
+
+    void WriteFlag(const char* key)
+    {
+      writer_.String(key);
+      writer_.Bool(true);
+    }
+
+    void WriteAccess(BinaryAccess access)
+    {
+      writer_.String(access == BinaryAccess::kPublic ? "public" :
+        access == BinaryAccess::kProtected ? "protected" : "private");
+    }
+
+    void WriteType(uint32_t id)
+    {
+      const BinaryType type = reader_.type(id);
+      writer_.StartObject();
+      if (type.isConst())
+        WriteFlag("const");
+      if (type.isMutable())
+        WriteFlag("mutable");
+      if (type.isVolatile())
+        WriteFlag("volatile");
+
+      writer_.String("type");
+      switch (type.kind())
+      {
+      case BinaryTypeKind::kFunction:
+        writer_.String("function");
+        writer_.String("returnType");
+        WriteType(type.returnType());
+        writer_.String("arguments");
+        writer_.StartArray();
+        for (uint32_t i = 0; i < type.argumentCount(); ++i)
+        {
+          const BinaryTypeArgument argument = type.argument(i);
+          writer_.StartObject();
+          if (!argument.name().empty())
+          {
+            writer_.String("name");
+            WriteString(argument.name());
+          }
+          writer_.String("type");
+          WriteType(argument.type());
+          writer_.EndObject();
+        }
+        writer_.EndArray();
+        break;
+      case BinaryTypeKind::kLReference:
+      case BinaryTypeKind::kPointer:
+      case BinaryTypeKind::kReference:
+        writer_.String(type.kind() == BinaryTypeKind::kLReference ? "lreference" :
+          type.kind() == BinaryTypeKind::kPointer ? "pointer" : "reference");
+        writer_.String("baseType");
+        WriteType(type.base());
+        break;
+      case BinaryTypeKind::kLiteral:
+        writer_.String("literal");
+        writer_.String("name");
+        WriteString(type.name());
+        break;
+      case BinaryTypeKind::kTemplate:
+        writer_.String("template");
+        writer_.String("name");
+        WriteString(type.name());
+        writer_.String("arguments");
+        writer_.StartArray();
+        for (uint32_t i = 0; i < type.argumentCount(); ++i)
+          WriteType(type.argument(i).type());
+        writer_.EndArray();
+        break;
+      }
+      writer_.EndObject();
+    }
+
+    void WriteValue(const BinaryValue& value)
+    {
+      switch (value.type())
+      {
+      case BinaryValueType::kText: WriteString(value.text()); break;
+      case BinaryValueType::kBoolean: writer_.Bool(value.boolean()); break;
+      case BinaryValueType::kUInt32: writer_.Uint(value.uint32()); break;
+      case BinaryValueType::kInt32: writer_.Int(value.int32()); break;
+      case BinaryValueType::kUInt64: writer_.Uint64(value.uint64()); break;
+      case BinaryValueType::kInt64: writer_.Int64(value.int64()); break;
+      case BinaryValueType::kReal: writer_.Double(value.real()); break;
+      default: writer_.Null(); break;
+      }
+    }
+
+    /// Writes the meta entries from index to end as an object and returns the index after them
+    uint32_t WriteMeta(const BinaryDeclaration& declaration, uint32_t index, uint32_t end)
+    {
+      writer_.StartObject();
+      while (index < end)
+      {
+        const BinaryMetaEntry entry = declaration.meta(index++);
+        WriteString(entry.key());
+        if (entry.value().type() == BinaryValueType::kSequence)
+          index = WriteMeta(declaration, index, index + entry.value().count());
+        else
+          WriteValue(entry.value());
+      }
+      writer_.EndObject();
+      return index;
+    }
+
+    void WriteDeclarationMeta(const BinaryDeclaration& declaration)
+    {
+      writer_.String("meta");
+      WriteMeta(declaration, 0, declaration.metaCount());
+    }
+
+    void WriteDeclarationAccess(const BinaryDeclaration& declaration)
+    {
+      if (declaration.access() == BinaryAccess::kNone)
+        return;
+      writer_.String("access");
+      WriteAccess(declaration.access());
+    }
+
+    void WriteComment(const BinaryDeclaration& declaration)
+    {
+      if (declaration.comment().empty())
+        return;
+      writer_.String("comment");
+      WriteString(declaration.comment());
+    }
+
+    void WriteArguments(const BinaryDeclaration& declaration)
+    {
+      writer_.String("arguments");
+      writer_.StartArray();
+      for (uint32_t i = 0; i < declaration.argumentCount(); ++i)
+      {
+        const BinaryArgument argument = declaration.argument(i);
+        writer_.StartObject();
+        writer_.String("type");
+        WriteType(argument.type());
+        writer_.String("name");
+        WriteString(argument.name());
+        if (argument.defaultValue().type() != BinaryValueType::kNone)
+        {
+          writer_.String("defaultValue");
+          WriteValue(argument.defaultValue());
+        }
+        writer_.EndObject();
+      }
+      writer_.EndArray();
+    }
+
+    void WriteClass(const BinaryDeclaration& declaration)
+    {
+      writer_.String("class");
+      writer_.String("line");
+      writer_.Uint(declaration.line());
+      WriteDeclarationAccess(declaration);
+      WriteComment(declaration);
+      WriteDeclarationMeta(declaration);
+
+      if (declaration.is(kBinaryTemplate))
+      {
+        writer_.String("template");
+        writer_.StartObject();
+        writer_.String("arguments");
+        writer_.StartArray();
+        for (uint32_t i = 0; i < declaration.templateArgumentCount(); ++i)
+        {
+          const BinaryTemplateArgument argument = declaration.templateArgument(i);
+          writer_.StartObject();
+          writer_.String("typeParameterKey");
+          WriteString(argument.typeParameterKey());
+          writer_.String("name");
+          WriteString(argument.name());
+          if (argument.defaultType() != kBinaryNoType)
+          {
+            writer_.String("defaultType");
+            WriteType(argument.defaultType());
+          }
+          writer_.EndObject();
+        }
+        writer_.EndArray();
+        writer_.EndObject();
+      }
+
+      writer_.String("isstruct");
+      writer_.Bool(declaration.is(kBinaryStruct));
+      writer_.String("name");
+      WriteString(declaration.name());
+
+      if (declaration.parentCount() > 0)
+      {
+        writer_.String("parents");
+        writer_.StartArray();
+        for (uint32_t i = 0; i < declaration.parentCount(); ++i)
+        {
+          const BinaryParent parent = declaration.parent(i);
+          writer_.StartObject();
+          writer_.String("access");
+          WriteAccess(parent.access());
+          writer_.String("name");
+          WriteType(parent.type());
+          writer_.EndObject();
+        }
+        writer_.EndArray();
+      }
+
+      writer_.String("members");
+      WriteDeclarations(declaration.index() + 1, declaration.end());
+    }
+
+    void WriteEnum(const BinaryDeclaration& declaration)
+    {
+      writer_.String("enum");
+      writer_.String("line");
+      writer_.Uint(declaration.line());
+      WriteDeclarationAccess(declaration);
+      WriteDeclarationMeta(declaration);
+      writer_.String("name");
+      WriteString(declaration.name());
+      if (declaration.is(kBinaryEnumClass))
+        WriteFlag("cxxclass");
+      if (!declaration.base().empty())
+      {
+        writer_.String("base");
+        WriteString(declaration.base());
+      }
+
+      writer_.String("members");
+      writer_.StartArray();
+      for (uint32_t i = 0; i < declaration.enumeratorCount(); ++i)
+      {
+        const BinaryEnumerator enumerator = declaration.enumerator(i);
+        writer_.StartObject();
+        writer_.String("key");
+        WriteString(enumerator.key());
+        if (enumerator.hasValue())
+        {
+          writer_.String("value");
+          WriteString(enumerator.value());
+        }
+        writer_.EndObject();
+      }
+      writer_.EndArray();
+    }
+
+    void WriteProperty(const BinaryDeclaration& declaration)
+    {
+      writer_.String("property");
+      writer_.String("line");
+      writer_.Uint(declaration.line());
+      WriteDeclarationMeta(declaration);
+      WriteDeclarationAccess(declaration);
+      if (declaration.is(kBinaryMutable))
+        WriteFlag("mutable");
+      if (declaration.is(kBinaryStatic))
+        WriteFlag("static");
+      writer_.String("dataType");
+      WriteType(declaration.dataType());
+      writer_.String("name");
+      WriteString(declaration.name());
+      writer_.String("elements");
+      if (declaration.is(kBinaryArray))
+        WriteString(declaration.elements());
+      else
+        writer_.Null();
+    }
+
+    void WriteFunction(const BinaryDeclaration& declaration)
+    {
+      writer_.String("function");
+      writer_.String("macro");
+      WriteString(declaration.macro());
+      writer_.String("line");
+      writer_.Uint(declaration.line());
+      WriteComment(declaration);
+      WriteDeclarationMeta(declaration);
+      WriteDeclarationAccess(declaration);
+      if (declaration.is(kBinaryVirtual))
+        WriteFlag("virtual");
+      if (declaration.is(kBinaryInline))
+        WriteFlag("inline");
+      if (declaration.is(kBinaryConstExpr))
+        WriteFlag("constexpr");
+      if (declaration.is(kBinaryStatic))
+        WriteFlag("static");
+      writer_.String("returnType");
+      WriteType(declaration.returnType());
+      writer_.String("name");
+      WriteString(declaration.name());
+      WriteArguments(declaration);
+      if (declaration.is(kBinaryConst))
+        WriteFlag("const");
+      if (declaration.is(kBinaryAbstract))
+        WriteFlag("abstract");
+    }
+
+    void WriteConstructor(const BinaryDeclaration& declaration)
+    {
+      writer_.String("constructor");
+      writer_.String("line");
+      writer_.Uint(declaration.line());
+      WriteComment(declaration);
+      WriteDeclarationMeta(declaration);
+      WriteDeclarationAccess(declaration);
+      if (declaration.is(kBinaryInline))
+        WriteFlag("inline");
+      writer_.String("name");
+      WriteString(declaration.name());
+      WriteArguments(declaration);
+      if (declaration.is(kBinaryDefault))
+        WriteFlag("default");
+    }
+
+    void WriteDeclaration(const BinaryDeclaration& declaration)
+    {
+      writer_.StartObject();
+      writer_.String("type");
+      switch (declaration.kind())
+      {
+      case BinaryKind::kInclude:
+        writer_.String("include");
+        writer_.String("file");
+        WriteString(declaration.name());
+        break;
+      case BinaryKind::kNamespace:
+        writer_.String("namespace");
+        writer_.String("name");
+        WriteString(declaration.name());
+        writer_.String("members");
+        WriteDeclarations(declaration.index() + 1, declaration.end());
+        break;
+      case BinaryKind::kClass: WriteClass(declaration); break;
+      case BinaryKind::kEnum: WriteEnum(declaration); break;
+      case BinaryKind::kProperty: WriteProperty(declaration); break;
+      case BinaryKind::kFunction: WriteFunction(declaration); break;
+      case BinaryKind::kConstructor: WriteConstructor(declaration); break;
+      case BinaryKind::kMacro:
+        writer_.String("macro");
+        writer_.String("name");
+        WriteString(declaration.name());
+        writer_.String("line");
+        writer_.Uint(declaration.line());
+        WriteDeclarationAccess(declaration);
+        WriteDeclarationMeta(declaration);
+        break;
+      }
+      writer_.EndObject();
+    }
+
+    void WriteDeclarations(uint32_t index, uint32_t end)
+    {
+      writer_.StartArray();
+      while (index < end)
+      {
+        const BinaryDeclaration declaration = reader_.declaration(index);
+        WriteDeclaration(declaration);
+        index = declaration.end();
+      }
+      writer_.EndArray();
+    }
+
+  private:
+    const BinaryReader& reader_;
+    JsonWriter writer_;
+  };
+
+  /// Parses the input to json and to the binary format and expects the binary format to read back as
+  /// the same json
+  void expect_round_trip(const Options& options, const std::string& input)
+  {
+    Parser parser(options);
+    std::string json;
+    if (!parser.Parse(input.data(), input.size(), json))
+      return TestCase::Fail(__FILE__, __LINE__, std::string("parsing failed: ") + parser.error());
+
+    BinaryParser binaryParser(options);
+    std::string binary;
+    EXPECT(binaryParser.Parse(input.data(), input.size(), binary));
+
+    BinaryReader reader;
+    if (!reader.Open(binary.data(), binary.size()))
+      return TestCase::Fail(__FILE__, __LINE__, "the binary output cannot be read");
+    EXPECT(reader.declarationCount() > 0);
+
+    OutputStream stream;
+    BinaryJsonWriter(reader, stream).Write();
+    EXPECT_EQ(json, std::string(stream.data(), stream.size()));
+  }
+
+  /// Returns options that recognize the annotations of the example headers
+  Options example_options()
+  {
+    Options options;
+    options.classNameMacro = "TCLASS";
+    options.enumNameMacro = "TENUM";
+    options.functionNameMacro.push_back("TFUNC");
+    options.propertyNameMacro = "TPROPERTY";
+    options.constructorNameMacro = "TCONSTRUCTOR";
+    options.customMacros.push_back("TMACRO");
+    return options;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(BinaryRoundTripExample)
+{
+  std::ifstream file(TestCase::examplesDirectory + "/example.h", std::ios::binary);
+  EXPECT(file.good());
+  const std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  expect_round_trip(example_options(), input);
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(BinaryRoundTripAllDeclarations)
+{
+  // Every kind of declaration, type node and meta value that the binary format stores
+  expect_round_trip(example_options(),
+    "#include \"local.h\"\n"
+    "namespace outer { namespace inner {\n"
+    "/// A class with everything\n"
+    "TCLASS(Name=\"text\", Count=3, Negative=-4, Big=5000000000, Ratio=0.5, Flag=true, Nested(A=1, B(C=false)), Bare)\n"
+    "template<typename T, class U = std::vector<const T*>, typename V = T>\n"
+    "struct Everything : public Base<T>, protected Other, private Third\n"
+    "{\n"
+    "  TMACRO(Custom=1)\n"
+    "  TPROPERTY()\n"
+    "  mutable volatile uint64_t value[Count];\n"
+    "  TPROPERTY()\n"
+    "  static const char* const names;\n"
+    "  TPROPERTY()\n"
+    "  std::map<std::string, std::function<void(int, float&)>> callbacks;\n"
+    "  TPROPERTY()\n"
+    "  const Outer::Inner<T>& inner;\n"
+    "public:\n"
+    "  /** Builds it */\n"
+    "  TCONSTRUCTOR()\n"
+    "  inline Everything(int a = 1, float b = 2.5f, const char* c = \"x\", bool d = false, char e = 'e') {}\n"
+    "  TCONSTRUCTOR()\n"
+    "  Everything() = default;\n"
+    "protected:\n"
+    "  TFUNC(Const)\n"
+    "  virtual std::vector<int>& Get(uint64_t size = 18446744073709551615ull, int64_t offset = -9, unsigned u = 7u) const = 0;\n"
+    "  TFUNC()\n"
+    "  static constexpr inline int Sum(int a = 0x10, int b = 010, int c = Count + 1);\n"
+    "  TENUM(Flags)\n"
+    "  enum class Mode : uint8_t { kA, kB = 4, kC = kB | 1 };\n"
+    "};\n"
+    "}}\n"
+    "TENUM()\n"
+    "enum Plain { One, Two };\n"
+    "TFUNC()\n"
+    "void Free(int a = {}, Everything<int>&& e = Everything<int>());\n");
+}
@@ -0,0 +1,83 @@
+#include "test.h"
+#include "parser.h"
+#include <cstring>
+
+namespace {
+  /// Parses the input with the given options and returns the compact json, or the error
+  std::string parse(const Options& options, const char* input)
+  {
+    CompactParser parser(options);
+    std::string output;
+    if (!parser.Parse(input, strlen(input), output))
+      return std::string("ERROR: ") + parser.error();
+    return output;
+  }
+
+  /// Returns options that recognize TFUNC as the function macro
+  Options function_options()
+  {
+    Options options;
+    options.functionNameMacro.push_back("TFUNC");
+    return options;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(DefaultValuesAfterConstant)
+{
+  // The constant default of the first argument must not carry over to the others
+  EXPECT_EQ(
+    "[{\"type\":\"function\",\"macro\":\"TFUNC\",\"line\":1,\"meta\":{},"
+    "\"returnType\":{\"type\":\"literal\",\"name\":\"void\"},\"name\":\"f\",\"arguments\":["
+    "{\"type\":{\"type\":\"literal\",\"name\":\"float\"},\"name\":\"a\",\"defaultValue\":1.5},"
+    "{\"type\":{\"type\":\"pointer\",\"baseType\":{\"type\":\"literal\",\"name\":\"int\"}},\"name\":\"p\",\"defaultValue\":\"nullptr\"},"
+    "{\"type\":{\"type\":\"literal\",\"name\":\"int\"},\"name\":\"c\",\"defaultValue\":\"a+b\"}]}]",
+    parse(function_options(), "TFUNC()\nvoid f(float a = 1.5, int* p = nullptr, int c = a+b);\n"));
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(CustomMacroBeforeClosingBrace)
+{
+  // The class ends right after the annotation, the declarations after it must still be found
+  Options options = function_options();
+  options.customMacros.push_back("TMACRO");
+  EXPECT_EQ(
+    "[{\"type\":\"function\",\"macro\":\"TFUNC\",\"line\":5,\"meta\":{},"
+    "\"returnType\":{\"type\":\"literal\",\"name\":\"int\"},\"name\":\"f\",\"arguments\":["
+    "{\"type\":{\"type\":\"literal\",\"name\":\"int\"},\"name\":\"a\",\"defaultValue\":\"{}\"},"
+    "{\"type\":{\"type\":\"literal\",\"name\":\"int\"},\"name\":\"b\"}]},"
+    "{\"type\":\"include\",\"file\":\"vector\"}]",
+    parse(options, "class A\n{\n  TMACRO(X)\n};\nTFUNC()\nint f(int a = {}, int b);\n#include <vector>\n"));
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(ParseAfterManyIdentifiers)
+{
+  // The identifiers of the first input are dropped by Reset, the annotation macros have to remain
+  std::string many;
+  for (int i = 0; i < 70000; ++i)
+    many += "TFUNC() void identifier" + std::to_string(i) + "();\n";
+
+  CompactParser parser(function_options());
+  std::string output;
+  EXPECT(parser.Parse(many.data(), many.size(), output));
+
+  const std::string input = "TFUNC()\nvoid identifier5(int identifier6);\n";
+  output.clear();
+  EXPECT(parser.Parse(input.data(), input.size(), output));
+  EXPECT_EQ(parse(function_options(), input.c_str()), output);
+}
+
+//--------------------------------------------------------------------------------------------------
+TEST(NumericLiteralDigits)
+{
+  EXPECT_EQ("ERROR: 2:16: Invalid digit '8' in constant 08", parse(function_options(), "TFUNC()\nvoid f(int a = 08);\n"));
+  EXPECT_EQ("ERROR: 2:16: Invalid digit '9' in constant 019", parse(function_options(), "TFUNC()\nvoid f(int a = 019);\n"));
+  EXPECT_EQ("ERROR: 2:16: Invalid digit '2' in constant 0b102", parse(function_options(), "TFUNC()\nvoid f(int a = 0b102);\n"));
+
+  // Only the digit separator is skipped
+  const std::string output = parse(function_options(), "TFUNC()\nvoid f(int a = 0'17, int b = 1'000, int c = 09.5);\n");
+  EXPECT(output.find("\"defaultValue\":15}") != std::string::npos);
+  EXPECT(output.find("\"defaultValue\":1000}") != std::string::npos);
+  EXPECT(output.find("\"defaultValue\":9.5}") != std::string::npos);
+}
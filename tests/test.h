@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+/**
+ * @brief A minimal test harness.
+ * @details Every TEST registers a function that test_main.cc runs. A failing EXPECT reports the
+ * expression and its location and marks the test as failed, the test keeps running.
+ */
+class TestCase
+{
+public:
+  typedef void (*Function)();
+
+  TestCase(const char* name, Function function);
+
+  /// Runs the tests whose name starts with the given filter, returns the number of failed tests
+  /// or 1 if the filter matches no test
+  static int RunAll(const std::string& filter);
+
+  /// Reports a failure of the running test
+  static void Fail(const char* file, int line, const std::string& message);
+
+  /// The directory with the example headers, passed on the command line
+  static std::string examplesDirectory;
+
+private:
+  const char* name_;
+  Function function_;
+  TestCase* next_;
+
+  static TestCase* first_;
+  static bool failed_;
+};
+
+#define TEST(name) \
+  static void name(); \
+  static TestCase name##_case(#name, name); \
+  static void name()
+
+#define EXPECT(condition) \
+  do { \
+    if (!(condition)) \
+      TestCase::Fail(__FILE__, __LINE__, "expected " #condition); \
+  } while (false)
+
+#define EXPECT_EQ(expected, actual) \
+  do { \
+    const auto& expectedValue = (expected); \
+    const auto& actualValue = (actual); \
+    if (!(expectedValue == actualValue)) \
+    { \
+      std::ostringstream message; \
+      message << "expected " #actual " to be\n  " << expectedValue << "\nbut it is\n  " << actualValue; \
+      TestCase::Fail(__FILE__, __LINE__, message.str()); \
+    } \
+  } while (false)
@@ -0,0 +1,73 @@
+#include "test.h"
+#include <iostream>
+
+TestCase* TestCase::first_ = nullptr;
+bool TestCase::failed_ = false;
+std::string TestCase::examplesDirectory;
+
+//--------------------------------------------------------------------------------------------------
+TestCase::TestCase(const char* name, Function function) :
+  name_(name),
+  function_(function),
+  next_(first_)
+{
+  first_ = this;
+}
+
+//--------------------------------------------------------------------------------------------------
+int TestCase::RunAll(const std::string& filter)
+{
+  // Tests register in reverse order of their definition, run them in order
+  TestCase* reversed = nullptr;
+  while (first_ != nullptr)
+  {
+    TestCase* next = first_->next_;
+    first_->next_ = reversed;
+    reversed = first_;
+    first_ = next;
+  }
+  first_ = reversed;
+
+  int failures = 0;
+  int run = 0;
+  for (TestCase* test = first_; test != nullptr; test = test->next_)
+  {
+    if (std::string(test->name_).compare(0, filter.size(), filter) != 0)
+      continue;
+
+    ++run;
+    failed_ = false;
+    test->function_();
+    std::cout << (failed_ ? "FAILED " : "passed ") << test->name_ << std::endl;
+    if (failed_)
+      ++failures;
+  }
+
+  // A filter that no longer matches would otherwise pass without running anything
+  if (run == 0)
+  {
+    std::cout << "No test starts with " << filter << std::endl;
+    ++failures;
+  }
+  return failures;
+}
+
+//--------------------------------------------------------------------------------------------------
+void TestCase::Fail(const char* file, int line, const std::string& message)
+{
+  std::cout << file << ":" << line << ": " << message << std::endl;
+  failed_ = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cout << "Usage: header-parser-tests examplesDirectory [filter]" << std::endl;
+    return 2;
+  }
+
+  TestCase::examplesDirectory = argv[1];
+  return TestCase::RunAll(argc > 2 ? argv[2] : "") == 0 ? 0 : 1;
+}
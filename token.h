@@ -1,9 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <array>
 
+/// Identifies an interned identifier, see AtomTable
+typedef uint32_t Atom;
+
 enum class TokenType
 {
   kNone,
@@ -23,14 +27,67 @@ enum class ConstType
   kReal
 };
 
+/// Non-owning view of a range of characters
+struct StringView
+{
+  StringView() : data(nullptr), length(0) {}
+  StringView(const char* d, std::size_t l) : data(d), length(l) {}
+
+  std::string str() const { return std::string(data, length); }
+  bool empty() const { return length == 0; }
+
+  bool operator==(const char* other) const
+  {
+    return std::strncmp(data, other, length) == 0 && other[length] == '\0';
+  }
+  bool operator==(const std::string& other) const
+  {
+    return other.size() == length && std::memcmp(data, other.data(), length) == 0;
+  }
+  bool operator!=(const char* other) const { return !(*this == other); }
+  bool operator!=(const std::string& other) const { return !(*this == other); }
+
+  const char* data;
+  std::size_t length;
+};
+
+inline bool operator==(const std::string& lhs, const StringView& rhs) { return rhs == lhs; }
+inline bool operator!=(const std::string& lhs, const StringView& rhs) { return rhs != lhs; }
+
 struct Token
 {
-	TokenType tokenType;
-  std::size_t startPos;
-  std::size_t startLine;
-  std::string token;
+  Token() : uint64Const(0) {}
+  Token(const Token& other) : uint64Const(0) { *this = other; }
+  Token& operator=(const Token& other)
+  {
+    tokenType = other.tokenType;
+    startPos = other.startPos;
+    index = other.index;
+    atom = other.atom;
+    constType = other.constType;
+    std::memcpy(&uint64Const, &other.uint64Const, sizeof(uint64Const));
+    stringConst = other.stringConst;
+
+    // Escaped string constants refer to our own copy of the unescaped text
+    token = other.token.data == other.stringConst.data() ?
+      StringView(stringConst.data(), stringConst.size()) : other.token;
+    return *this;
+  }
+
+	TokenType tokenType = TokenType::kNone;
+  std::size_t startPos = 0;
 
-  ConstType constType;
+  /// Index of the token in the token array if the input was tokenized ahead
+  std::size_t index = 0;
+
+  /// The text of the token. Refers to the input of the tokenizer, except for string constants that
+  /// contain escape sequences which refer to the unescaped text in stringConst.
+  StringView token;
+
+  /// The interned text of identifiers, kAtomNone for all other tokens
+  Atom atom = 0;
+
+  ConstType constType = ConstType::kString;
   union
   {
     bool boolConst;
@@ -40,5 +97,7 @@ struct Token
     int64_t int64Const;
     double realConst;
   };
+
+  /// Storage for the unescaped text of string constants with escape sequences, empty otherwise.
   std::string stringConst;
 };
\ No newline at end of file
@@ -1,14 +1,201 @@
 #include "tokenizer.h"
 #include "token.h"
+#include "char_class.h"
+#include "char_scan.h"
+#include <algorithm>
 #include <string>
-#include <cctype>
-#include <stdexcept>
 #include <vector>
-#include <sstream>
 #include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 namespace {
   static const char EndOfFileChar = std::char_traits<char>::to_char_type(std::char_traits<char>::eof());
+
+  //------------------------------------------------------------------------------------------------
+  inline unsigned DigitValue(char c)
+  {
+    if (c >= '0' && c <= '9')
+      return static_cast<unsigned>(c - '0');
+    if (c >= 'a' && c <= 'f')
+      return static_cast<unsigned>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F')
+      return static_cast<unsigned>(c - 'A' + 10);
+    return 0xFF;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /// Skips digits of the given base, including digit separators between them
+  inline const char* SkipDigits(const char* first, const char* last, unsigned base)
+  {
+    for (; first != last; ++first)
+    {
+      if (*first == '\'' && first + 1 != last && DigitValue(first[1]) < base)
+        continue;
+      if (DigitValue(*first) >= base)
+        break;
+    }
+    return first;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /// Accumulates the digits in the given range, skipping digit separators. Returns the first digit that
+  /// is out of range for the base, or last if there is none. fits is cleared if the value does not fit
+  /// in 64 bits.
+  inline const char* AccumulateDigits(const char* first, const char* last, unsigned base, uint64_t& value, bool& fits)
+  {
+    fits = true;
+    value = 0;
+    for (; first != last; ++first)
+    {
+      if (*first == '\'')
+        continue;
+      unsigned digit = DigitValue(*first);
+      if (digit >= base)
+        return first;
+      if (value > (UINT64_MAX - digit) / base)
+        fits = false;
+      value = value * base + digit;
+    }
+    return last;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  /**
+   * @brief Parses the numeric literal that starts at first.
+   * @details Handles an optional sign, decimal, octal, hexadecimal and binary integers, decimal and
+   * hexadecimal floating point values, digit separators and suffixes (including user defined ones).
+   * The constant type and value of the token are set directly. Returns the end of the literal, and sets
+   * invalidDigit to a digit that is out of range for the base of an integer, like the 8 of 08, or to
+   * nullptr if the literal is valid.
+   */
+  const char* ParseNumericLiteral(const char* first, const char* last, Token& token, const char*& invalidDigit)
+  {
+    invalidDigit = nullptr;
+    const char* p = first;
+    bool isNegated = *p == '-';
+    if (*p == '-' || *p == '+')
+      ++p;
+
+    // Base prefix
+    unsigned base = 10;
+    if (last - p >= 3 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && (DigitValue(p[2]) < 16 || p[2] == '.'))
+    {
+      base = 16;
+      p += 2;
+    }
+    else if (last - p >= 3 && p[0] == '0' && (p[1] == 'b' || p[1] == 'B') && DigitValue(p[2]) < 2)
+    {
+      base = 2;
+      p += 2;
+    }
+
+    // Integer part
+    const char* digitsFirst = p;
+    p = SkipDigits(p, last, base);
+    const char* digitsLast = p;
+
+    // Fraction and exponent make it a floating point value
+    bool isFloat = false;
+    if (base != 2)
+    {
+      if (p != last && *p == '.')
+      {
+        isFloat = true;
+        p = SkipDigits(p + 1, last, base);
+      }
+
+      const char exponent = base == 16 ? 'p' : 'e';
+      if (p != last && (*p | 0x20) == exponent)
+      {
+        const char* q = p + 1;
+        if (q != last && (*q == '+' || *q == '-'))
+          ++q;
+        if (q != last && DigitValue(*q) < 10)
+        {
+          isFloat = true;
+          p = SkipDigits(q, last, 10);
+        }
+      }
+    }
+
+    const char* valueLast = p;
+
+    // Suffixes are not interpreted, but do not start with a digit
+    if (p != last && DigitValue(*p) < 10)
+      invalidDigit = p;
+    p = ScanIdentifier(p, last);
+
+    if (isFloat)
+    {
+      // Copy the value without digit separators so the C library can convert it
+      char buffer[128];
+      std::size_t length = 0;
+      for (const char* c = first; c != valueLast && length + 1 < sizeof(buffer); ++c)
+        if (*c != '\'')
+          buffer[length++] = *c;
+      buffer[length] = '\0';
+
+      token.constType = ConstType::kReal;
+      token.realConst = std::strtod(buffer, nullptr);
+      return p;
+    }
+
+    // A leading zero makes a decimal literal octal
+    if (base == 10 && digitsLast - digitsFirst > 1 && *digitsFirst == '0')
+      base = 8;
+
+    uint64_t value;
+    bool fits;
+    const char* digitsEnd = AccumulateDigits(digitsFirst, digitsLast, base, value, fits);
+    if (digitsEnd != digitsLast)
+      invalidDigit = digitsEnd;
+
+    if (isNegated)
+    {
+      if (value <= static_cast<uint64_t>(INT32_MAX) + 1)
+      {
+        token.constType = ConstType::kInt32;
+        token.int32Const = static_cast<int32_t>(-static_cast<int64_t>(value));
+      }
+      else
+      {
+        token.constType = ConstType::kInt64;
+        token.int64Const = fits && value <= static_cast<uint64_t>(INT64_MAX) ?
+          -static_cast<int64_t>(value) : INT64_MIN;
+      }
+    }
+    else if (fits && value <= UINT32_MAX)
+    {
+      token.constType = ConstType::kUInt32;
+      token.uint32Const = static_cast<uint32_t>(value);
+    }
+    else
+    {
+      token.constType = ConstType::kUInt64;
+      token.uint64Const = fits ? value : UINT64_MAX;
+    }
+
+    return p;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Returns true for the identifiers that open a scope or change the access control of a scope
+  inline bool IsScopeKeyword(const StringView& text)
+  {
+    switch (text.length)
+    {
+    case 6:
+      return std::memcmp(text.data, "public", 6) == 0;
+    case 7:
+      return std::memcmp(text.data, "private", 7) == 0;
+    case 9:
+      return std::memcmp(text.data, "namespace", 9) == 0 || std::memcmp(text.data, "protected", 9) == 0;
+    default:
+      return false;
+    }
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -16,9 +203,10 @@ Tokenizer::Tokenizer() :
   input_(nullptr),
   inputLength_(0),
   cursorPos_(0),
-  cursorLine_(0)
+  prevCursorPos_(0),
+  tokenPos_(0)
 {
-
+  error_[0] = '\0';
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -28,19 +216,312 @@ Tokenizer::~Tokenizer()
 }
 
 //--------------------------------------------------------------------------------------------------
-void Tokenizer::Reset(const char* input, std::size_t startingLine)
+void Tokenizer::Reset(const char* input)
+{
+  Reset(input, std::char_traits<char>::length(input));
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::Reset(const char* input, std::size_t length, std::size_t startingLine)
 {
   input_ = input;
-  inputLength_ = std::char_traits<char>::length(input);
+  inputLength_ = length;
   cursorPos_ = 0;
-  cursorLine_ = startingLine;
+  prevCursorPos_ = 0;
+  tokenPos_ = 0;
+  startingLine_ = startingLine;
+  hasError_ = false;
+  error_[0] = '\0';
+  tokenized_ = false;
+  newlines_.clear();
+  lineIndexBuilt_ = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::Tokenize()
+{
+  TokenizeInput(nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::Tokenize(const std::vector<Landmark>& landmarks)
+{
+  TokenizeInput(&landmarks);
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::TokenizeInput(const std::vector<Landmark>* landmarks)
+{
+  tokenized_ = false;
+  tokens_.clear();
+  tokenIndex_ = 0;
+  openBraces_.clear();
+  comments_.clear();
+  escapedText_.clear();
+
+  // Positions are stored as 32 bit values, keep streaming from bigger inputs
+  if (inputLength_ >= UINT32_MAX)
+    return;
+
+  // Without landmarks every token is lexed in full
+  bool hot = landmarks == nullptr;
+  std::size_t nextLandmark = 0;
+  int32_t depth = 0;
+  int32_t hotDepth = 0;
+  bool keepNext = false;
+  bool placeholderOpen = false;
+
+  // Parentheses depth in the argument list of the last annotation, the parser accepts a ';' directly
+  // after the argument list
+  int32_t metaParens = -1;
+  bool metaEnded = false;
+
+  // The body of the last annotated declaration that has a skipped body is the first brace at its depth
+  // after its argument list. The body is lexed like the text between declarations.
+  bool bodyPending = false;
+  int32_t bodyDepth = 0;
+  int32_t bodyParens = 0;
+  bool argumentsClosed = false;
+  bool inBody = false;
+  int32_t bodyScopeDepth = 0;
+  int32_t bodyHotDepth = 0;
+
+  Token token;
+  for (;;)
+  {
+    // Skip to the next token that is kept without lexing the tokens in between
+    if (!hot && !keepNext && landmarks != nullptr)
+    {
+      const std::size_t limit = nextLandmark < landmarks->size() ?
+        std::min((*landmarks)[nextLandmark].position, inputLength_) : inputLength_;
+      placeholderOpen = SkipColdText(limit, placeholderOpen) || placeholderOpen;
+    }
+
+    if (!LexToken(token, false, true, hot))
+      break;
+
+    // Switch to full lexing at the first token of an annotated declaration
+    bool annotated = false;
+    bool skipBody = false;
+    while (landmarks != nullptr && nextLandmark < landmarks->size() &&
+           (*landmarks)[nextLandmark].position <= token.startPos)
+    {
+      const Landmark& landmark = (*landmarks)[nextLandmark++];
+      if (landmark.annotation)
+      {
+        annotated = true;
+        skipBody = landmark.skipBody;
+      }
+    }
+
+    // Every annotation starts a declaration at the current depth, also one that directly follows
+    // another annotated declaration that has not ended yet
+    if (annotated)
+    {
+      if (!hot && token.tokenType == TokenType::kIdentifier)
+        ClassifyIdentifier(token);
+      hot = true;
+      hotDepth = depth;
+    }
+
+    const char symbol = token.tokenType == TokenType::kSymbol && token.token.length == 1 ? token.token.data[0] : '\0';
+    if (symbol == '{')
+      ++depth;
+    else if (symbol == '}')
+      --depth;
+
+    const bool afterMeta = metaEnded;
+    metaEnded = false;
+    if (annotated)
+      metaParens = 0;
+    else if (metaParens >= 0 && symbol == '(')
+      ++metaParens;
+    else if (metaParens > 0 && symbol == ')')
+      metaEnded = --metaParens == 0;
+    else if (metaParens == 0)
+      metaParens = -1;
+    if (metaEnded)
+      metaParens = -1;
+
+    // Find the body of the declaration, annotations inside a skipped body do not start another one
+    bool isBody = false;
+    if (annotated && !inBody)
+    {
+      bodyPending = skipBody;
+      bodyDepth = depth;
+      bodyParens = 0;
+      argumentsClosed = false;
+    }
+    else if (bodyPending && metaParens < 0 && !metaEnded)
+    {
+      if (symbol == '(' && depth == bodyDepth)
+        ++bodyParens;
+      else if (symbol == ')' && depth == bodyDepth && bodyParens > 0)
+        argumentsClosed = --bodyParens == 0;
+      else if (symbol == '{' && depth == bodyDepth + 1 && bodyParens == 0 && argumentsClosed)
+        isBody = true;
+
+      // The declaration ends here or without a body
+      if (isBody || (symbol == ';' && depth == bodyDepth) || depth < bodyDepth)
+        bodyPending = false;
+    }
+
+    if (hot || keepNext || symbol == ';' || symbol == '{' || symbol == '}' || symbol == '#' ||
+        (token.tokenType == TokenType::kIdentifier && IsScopeKeyword(token.token)))
+    {
+      // Namespace names and the colon after access specifiers are kept as well
+      if (token.tokenType == TokenType::kIdentifier && token.atom == kAtomNone)
+        ClassifyIdentifier(token);
+      keepNext = !hot && !keepNext && token.tokenType == TokenType::kIdentifier;
+      PushToken(token);
+      placeholderOpen = false;
+    }
+    else
+    {
+      PushPlaceholder(token, placeholderOpen);
+      placeholderOpen = true;
+    }
+
+    // The body is not needed by the parser, the declaration continues after it
+    if (isBody)
+    {
+      inBody = true;
+      bodyScopeDepth = depth;
+      bodyHotDepth = hotDepth;
+      hot = false;
+      continue;
+    }
+    if (inBody && symbol == '}' && depth < bodyScopeDepth)
+    {
+      inBody = false;
+      hotDepth = bodyHotDepth;
+      hot = true;
+      continue;
+    }
+
+    // An annotated declaration ends at the semicolon at its own depth or with its enclosing scope. A
+    // semicolon directly after the argument list of an annotation or inside it belongs to the annotation.
+    if (hot && landmarks != nullptr && metaParens <= 0 &&
+        ((symbol == ';' && depth == hotDepth && !afterMeta) || (symbol == '}' && depth < hotDepth)))
+      hot = false;
+
+    // Lex preprocessor directives the way the parser would consume them
+    if (token.tokenType != TokenType::kSymbol || token.token != "#" ||
+        !LexToken(token, false, true))
+      continue;
+
+    PushToken(token);
+    if (token.tokenType != TokenType::kIdentifier)
+      continue;
+
+    bool isDefine = token.atom == kAtomDefine;
+    if (token.atom == kAtomInclude && LexToken(token, true, false))
+      PushToken(token);
+    SkipDirective(isDefine);
+  }
+
+  comment_ = Comment();
+  lastComment_ = Comment();
+  tokenized_ = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Tokenizer::SkipColdText(std::size_t limit, bool extend)
+{
+  if (limit <= cursorPos_)
+    return false;
+
+  // None of the skipped characters start a token that is kept, a comment or a string, so the skipped
+  // text consists of white space and complete tokens
+  const char* first = input_ + cursorPos_;
+  const char* last = FindStructural(first, input_ + limit);
+  const char* tokenFirst = SkipWhitespace(first, last);
+  Advance(static_cast<std::size_t>(last - input_));
+  if (tokenFirst == last)
+    return false;
+
+  comment_ = Comment();
+  Token placeholder;
+  placeholder.startPos = static_cast<std::size_t>(tokenFirst - input_);
+  PushPlaceholder(placeholder, extend);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t Tokenizer::PushComment()
+{
+  if (comment_.empty())
+    return kNoComment;
+
+  comments_.push_back(comment_);
+  return static_cast<uint32_t>(comments_.size() - 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::PushPlaceholder(const Token& token, bool extend)
+{
+  const std::size_t end = cursorPos_ < inputLength_ ? cursorPos_ : inputLength_;
+  if (extend)
+  {
+    tokens_.back().textLength = static_cast<uint32_t>(end - tokens_.back().textPos);
+    return;
+  }
+
+  LexedToken lexed;
+  lexed.startPos = lexed.textPos = static_cast<uint32_t>(token.startPos);
+  lexed.textLength = static_cast<uint32_t>(end - token.startPos);
+  lexed.comment = PushComment();
+  lexed.tokenType = static_cast<uint8_t>(TokenType::kNone);
+  lexed.constType = 0;
+  lexed.isEscaped = false;
+  lexed.partner = kNoPartner;
+  lexed.value = 0;
+  tokens_.push_back(lexed);
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::PushToken(const Token& token)
+{
+  LexedToken lexed;
+  lexed.startPos = static_cast<uint32_t>(token.startPos);
+  lexed.textLength = static_cast<uint32_t>(token.token.length);
+  lexed.isEscaped = !token.stringConst.empty() && token.token.data == token.stringConst.data();
+  if (lexed.isEscaped)
+  {
+    lexed.textPos = static_cast<uint32_t>(escapedText_.size());
+    escapedText_.append(token.token.data, token.token.length);
+  }
+  else
+    lexed.textPos = static_cast<uint32_t>(token.token.data - input_);
+
+  lexed.comment = PushComment();
+
+  lexed.tokenType = static_cast<uint8_t>(token.tokenType);
+  lexed.constType = static_cast<uint8_t>(token.constType);
+
+  // Pair up the braces as they come in
+  lexed.partner = kNoPartner;
+  const uint32_t index = static_cast<uint32_t>(tokens_.size());
+  if (token.tokenType == TokenType::kSymbol && token.token == "{")
+    openBraces_.push_back(index);
+  else if (token.tokenType == TokenType::kSymbol && token.token == "}" && !openBraces_.empty())
+  {
+    lexed.partner = openBraces_.back();
+    tokens_[openBraces_.back()].partner = index;
+    openBraces_.pop_back();
+  }
+  if (token.tokenType == TokenType::kIdentifier)
+    lexed.value = token.atom;
+  else
+    std::memcpy(&lexed.value, &token.uint64Const, sizeof(lexed.value));
+
+  tokens_.push_back(lexed);
 }
 
 //--------------------------------------------------------------------------------------------------
 char Tokenizer::GetChar()
 { 
 	prevCursorPos_ = cursorPos_;
-  prevCursorLine_ = cursorLine_;
 
   if(is_eof())
 	{
@@ -48,20 +529,12 @@ char Tokenizer::GetChar()
     return EndOfFileChar;
 	}
 	
-  char c = input_[cursorPos_];
-
-  // New line moves the cursor to the new line
-  if(c == '\n')
-    cursorLine_++;
-
-  cursorPos_++;
-  return c;
+  return input_[cursorPos_++];
 }
 
 //--------------------------------------------------------------------------------------------------
 void Tokenizer::UngetChar()
 {
-  cursorLine_ = prevCursorLine_;
   cursorPos_ = prevCursorPos_;
 }
 
@@ -73,94 +546,72 @@ char Tokenizer::peek() const
             EndOfFileChar;
 }
 
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::Advance(std::size_t position)
+{
+  if (position <= cursorPos_)
+    return;
+
+  cursorPos_ = position;
+
+  // Make the last character of the skipped range the last read character
+  prevCursorPos_ = position - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::SkipWhitespaceRun()
+{
+  if (is_eof())
+    return;
+
+  const char* first = input_ + cursorPos_;
+  const char* last = SkipWhitespace(first, input_ + inputLength_);
+  cursorPos_ = static_cast<std::size_t>(last - input_);
+  if (last != first)
+    prevCursorPos_ = cursorPos_ - 1;
+}
+
 //--------------------------------------------------------------------------------------------------
 char Tokenizer::GetLeadingChar()
 {
-  if (!comment_.text.empty())
+  if (!comment_.empty())
     lastComment_ = comment_;
 
-  comment_.text = "";
-  comment_.startLine = cursorLine_;
-  comment_.endLine = cursorLine_;
+  comment_.startPos = comment_.endPos = comment_.nextPos = cursorPos_;
 
   char c;
-  for(c = GetChar(); c != EndOfFileChar; c = GetChar())
+  for(;;)
   {
-    // If this is a whitespace character skip it
-    std::char_traits<char>::int_type intc = std::char_traits<char>::to_int_type(c);
+    // Skip white space and control characters in bulk
+    SkipWhitespaceRun();
 
-    // In case of a new line
-    if (c == '\n')
-    {
-      if (!comment_.text.empty())
-        comment_.text += "\n";
-      continue;
-    }
-
-    if(std::isspace(intc) || std::iscntrl(intc))
-      continue;
+    c = GetChar();
+    if (c == EndOfFileChar)
+      break;
 
-    // If this is a single line comment
+    // If this is a single line comment, skip it and all the single line comments that directly follow
     char next = peek();
     if(c == '/' && next == '/')
     {
-      std::vector<std::string> lines;
+      comment_.startPos = prevCursorPos_;
 
-      size_t indentationLastLine = 0;
       while (!is_eof() && c == '/' && next == '/')
       {
         // Search for the end of the line
-        std::string line;
-        for (c = GetChar();
-          c != EndOfFileChar && c != '\n';
-          c = GetChar())
-        {
-          line += c;
-        }
-        
-        // Store the line
-        size_t lastSlashIndex = line.find_first_not_of("/");
-        if (lastSlashIndex == std::string::npos)
-          line = "";
-        else
-          line = line.substr(lastSlashIndex);
-
-        size_t firstCharIndex = line.find_first_not_of(" \t");
-        if (firstCharIndex == std::string::npos)
-          line = "";
-        else
-          line = line.substr(firstCharIndex);
-
-        if (firstCharIndex > indentationLastLine && !lines.empty())
-          lines.back() += std::string(" ") + line;
-        else
-        {
-          lines.emplace_back(std::move(line));
-          indentationLastLine = firstCharIndex;
-        }
+        const char* lineEnd = FindNewline(input_ + cursorPos_, input_ + inputLength_);
+        cursorPos_ = comment_.endPos = static_cast<std::size_t>(lineEnd - input_);
+        GetChar();
 
         // Check the next line
-        while (!is_eof() && std::isspace(c = GetChar()));
-
+        SkipWhitespaceRun();
         if (!is_eof())
-          next = peek();
-      }
-
-      // Unget previously get char
-      if (!is_eof())
-        UngetChar();
-
-      // Build comment string
-      std::stringstream ss;
-      for (size_t i = 0; i < lines.size(); ++i)
-      {
-        if (i > 0)
-          ss << "\n";
-        ss << lines[i];
+        {
+          c = input_[cursorPos_];
+          next = cursorPos_ + 1 < inputLength_ ? input_[cursorPos_ + 1] : EndOfFileChar;
+        }
       }
 
-      comment_.text = ss.str();
-      comment_.endLine = cursorLine_;
+      comment_.nextPos = cursorPos_;
 
       // Go to the next
       continue;
@@ -169,50 +620,17 @@ char Tokenizer::GetLeadingChar()
     // If this is a block comment
     if(c == '/' && next == '*')
     {
-      // Search for the end of the block comment
-      std::vector<std::string> lines;
-      std::string line;
-      for (c = GetChar(), next = peek();
-        c != EndOfFileChar && (c != '*' || next != '/');
-        c = GetChar(), next = peek())
-      {
-        if (c == '\n')
-        {
-          if (!lines.empty() || !line.empty())
-            lines.emplace_back(line);
-          line.clear();
-        }
-        else
-        {
-          if (!line.empty() || !(std::isspace(c) || c == '*'))
-            line += c;
-        }
-      }
+      comment_.startPos = prevCursorPos_;
 
-      // Skip past the slash
-      if(c != EndOfFileChar)
-        GetChar();
+      // Search for the end of the block comment, the opening star is part of the search so "/*/" is a
+      // complete comment.
+      const char* last = FindBlockCommentEnd(input_ + cursorPos_, input_ + inputLength_);
+      Advance(last == input_ + inputLength_ ? inputLength_ : static_cast<std::size_t>(last - input_) + 2);
+      comment_.endPos = cursorPos_;
 
       // Skip past new lines and spaces
-      while (!is_eof() && std::isspace(c = GetChar()));
-      if (!is_eof())
-        UngetChar();
-
-      // Remove empty lines from the back
-      while (!lines.empty() && lines.back().empty())
-        lines.pop_back();
-
-      // Build comment string
-      std::stringstream ss;
-      for (size_t i = 0; i < lines.size(); ++i)
-      {
-        if (i > 0)
-          ss << "\n";
-        ss << lines[i]; 
-      }
-
-      comment_.text = ss.str();
-      comment_.endLine = cursorLine_;
+      SkipWhitespaceRun();
+      comment_.nextPos = cursorPos_;
 
       // Move to the next character
       continue;
@@ -224,14 +642,127 @@ char Tokenizer::GetLeadingChar()
   return c;
 }
 
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::CommentText(const Comment& comment, std::string& text) const
+{
+  text.clear();
+  const char* first = input_ + comment.startPos;
+  const char* last = input_ + comment.endPos;
+  if (last - first < 2)
+    return;
+
+  if (first[1] == '/')
+  {
+    // Strip the slashes and indentation of every line. A line that is indented further than the
+    // previous line continues that line.
+    bool firstLine = true;
+    size_t indentationLastLine = 0;
+    while (first < last)
+    {
+      const char* lineEnd = FindNewline(first, last);
+
+      while (first != lineEnd && *first == '/')
+        ++first;
+      const char* lineStart = first;
+      while (lineStart != lineEnd && (*lineStart == ' ' || *lineStart == '\t'))
+        ++lineStart;
+      size_t indentation = lineStart != lineEnd ? static_cast<size_t>(lineStart - first) : std::string::npos;
+
+      if (indentation > indentationLastLine && !firstLine)
+        text += ' ';
+      else
+      {
+        if (!firstLine)
+          text += '\n';
+        indentationLastLine = indentation;
+      }
+      text.append(lineStart, lineEnd);
+      firstLine = false;
+
+      first = SkipWhitespace(lineEnd, last);
+    }
+  }
+  else
+  {
+    // Strip the comment markers, leading white space and stars from every line. The text after the
+    // last new line is not part of the comment.
+    if (last - first >= 3 && last[-2] == '*' && last[-1] == '/')
+      last -= 2;
+
+    bool firstLine = true;
+    for (const char* lineEnd = FindNewline(++first, last); lineEnd != last; lineEnd = FindNewline(first, last))
+    {
+      while (first != lineEnd && (*first == '*' || HasCharClass(*first, kCharSpace)))
+        ++first;
+      if (!firstLine || first != lineEnd)
+      {
+        if (!firstLine)
+          text += '\n';
+        text.append(first, lineEnd);
+        firstLine = false;
+      }
+      first = lineEnd + 1;
+    }
+
+    // Remove empty lines from the back
+    while (!text.empty() && text.back() == '\n')
+      text.pop_back();
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 bool Tokenizer::GetToken(Token &token, bool angleBracketsForStrings, bool seperateBraces)
+{
+  if (!tokenized_)
+    return LexToken(token, angleBracketsForStrings, seperateBraces);
+
+  if (tokenIndex_ >= tokens_.size())
+    return false;
+
+  const LexedToken& lexed = tokens_[tokenIndex_];
+  token.index = tokenIndex_++;
+  token.startPos = lexed.startPos;
+  token.tokenType = static_cast<TokenType>(lexed.tokenType);
+  token.constType = static_cast<ConstType>(lexed.constType);
+  token.token = StringView((lexed.isEscaped ? escapedText_.data() : input_) + lexed.textPos, lexed.textLength);
+  token.stringConst.clear();
+  if (token.tokenType == TokenType::kIdentifier)
+    token.atom = static_cast<Atom>(lexed.value);
+  else
+  {
+    token.atom = kAtomNone;
+    std::memcpy(&token.uint64Const, &lexed.value, sizeof(lexed.value));
+  }
+
+  // The token array always has separate closing braces, join them unless requested otherwise
+  if (!seperateBraces && token.tokenType == TokenType::kSymbol && token.token == ">" &&
+      tokenIndex_ < tokens_.size())
+  {
+    const LexedToken& next = tokens_[tokenIndex_];
+    if (next.startPos == lexed.startPos + 1 && next.textLength == 1 &&
+        static_cast<TokenType>(next.tokenType) == TokenType::kSymbol && input_[next.startPos] == '>')
+    {
+      token.token.length = 2;
+      ++tokenIndex_;
+    }
+  }
+
+  // Track the comment and position of the last token for ParseComment and error reporting
+  if (lexed.comment != kNoComment)
+    lastComment_ = comments_[lexed.comment];
+  else
+    lastComment_ = Comment();
+  tokenPos_ = lexed.startPos;
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Tokenizer::LexToken(Token &token, bool angleBracketsForStrings, bool seperateBraces, bool classifyIdentifiers)
 {
   // Get the next character
   char c = GetLeadingChar();
-  char p = peek();
-  std::char_traits<char>::int_type intc = std::char_traits<char>::to_int_type(c);
-  std::char_traits<char>::int_type intp = std::char_traits<char>::to_int_type(p);
+  const uint8_t charClass = CharClass(c);
 
   if(c == EndOfFileChar)
   {
@@ -240,178 +771,97 @@ bool Tokenizer::GetToken(Token &token, bool angleBracketsForStrings, bool sepera
   }
 
   // Record the start of the token position
-  token.startPos = prevCursorPos_;
-  token.startLine = prevCursorLine_;
-  token.token.clear();
+  token.startPos = tokenPos_ = prevCursorPos_;
+  token.token = StringView();
+  token.stringConst.clear();
+  token.atom = kAtomNone;
   token.tokenType = TokenType::kNone;
 
   // Alphanumeric token
-  if(std::isalpha(intc) || c == '_')
+  if(charClass & kCharIdentifierStart)
   {
     // Read the rest of the alphanumeric characters
-    do
-    {
-      token.token.push_back(c);
-      c = GetChar();
-      intc = std::char_traits<char>::to_int_type(c);
-    } while(std::isalnum(intc) || c == '_');
-
-    // Put back the last read character since it's not part of the identifier
-    UngetChar();
+    const char* last = ScanIdentifier(input_ + cursorPos_, input_ + inputLength_);
+    token.token = StringView(input_ + token.startPos, static_cast<std::size_t>(last - input_) - token.startPos);
+    cursorPos_ = prevCursorPos_ = static_cast<std::size_t>(last - input_);
 
     // Set the type of the token
     token.tokenType = TokenType::kIdentifier;
-
-    if(token.token == "true")
-    {
-      token.tokenType = TokenType::kConst;
-      token.constType = ConstType::kBoolean;
-      token.boolConst = true;
-    }
-    else if(token.token == "false")
-    {
-      token.tokenType = TokenType::kConst;
-      token.constType = ConstType::kBoolean;
-      token.boolConst = false;
-    }
+    if (classifyIdentifiers)
+      ClassifyIdentifier(token);
 
     return true;
   }
   // Constant
-  else if(std::isdigit(intc) || ((c == '-' || c == '+') && std::isdigit(intp)))
+  else if((charClass & kCharDigit) || ((charClass & kCharNumberSign) && HasCharClass(peek(), kCharDigit)))
   {
-    bool isFloat = false;
-    bool isHex = false;
-    bool isNegated = c == '-';
-    do
-    {
-      if(c == '.')
-        isFloat = true;
-
-      if(c == 'x' || c == 'X')
-        isHex = true;
-
-      token.token.push_back(c);
-      c = GetChar();
-      intc = std::char_traits<char>::to_int_type(c);
-
-    } while(std::isdigit(intc) ||
-        (!isFloat && c == '.') ||
-        (!isHex && (c == 'X' || c == 'x')) ||
-        (isHex && std::isxdigit(intc)));
-
-    if(!isFloat || (c != 'f' && c != 'F'))
-      UngetChar();
-
+    const char* invalidDigit;
+    const char* last = ParseNumericLiteral(input_ + token.startPos, input_ + inputLength_, token, invalidDigit);
+    token.token = StringView(input_ + token.startPos, static_cast<std::size_t>(last - input_) - token.startPos);
+    cursorPos_ = prevCursorPos_ = static_cast<std::size_t>(last - input_);
     token.tokenType = TokenType::kConst;
-    if(!isFloat)
-    {
-      try
-      {
-        if(isNegated)
-        {
-          token.int32Const = std::stoi(token.token, 0, 0);
-          token.constType = ConstType::kInt32;
-        }
-        else
-        {
-          token.uint32Const = std::stoul(token.token, 0, 0);
-          token.constType = ConstType::kUInt32;
-        }
-      }
-      catch(std::out_of_range)
-      {
-        if(isNegated)
-        {
-          token.int64Const = std::stoll(token.token, 0, 0);
-          token.constType = ConstType::kInt64;
-        }
-        else
-        {
-          token.uint64Const = std::stoull(token.token, 0, 0);
-          token.constType = ConstType::kUInt64;
-        }
-      }
-    }
-    else
-    {
-      token.realConst = std::stod(token.token);
-      token.constType = ConstType::kReal;
-    }
-
+    if (invalidDigit != nullptr)
+      return Error("Invalid digit '%c' in constant %s", *invalidDigit, token.token.str().c_str());
     return true;
   }
   else if (c == '"' || (angleBracketsForStrings && c == '<'))
   {
     const char closingElement = c == '"' ? '"' : '>';
 
-    c = GetChar();
-    while (c != closingElement && std::char_traits<char>::not_eof(std::char_traits<char>::to_int_type(c)))
+    // The text of the constant refers to the input unless it contains escape sequences
+    const std::size_t first = cursorPos_;
+    std::size_t last = first;
+    bool hasEscapes = false;
+    while (!is_eof())
     {
-      if(c == '\\')
+      // Skip everything up to the closing element or the next escape sequence in bulk
+      const char* end = FindStringEnd(input_ + cursorPos_, input_ + inputLength_, closingElement);
+      if (hasEscapes)
+        token.stringConst.append(input_ + cursorPos_, end);
+      Advance(static_cast<std::size_t>(end - input_));
+      last = cursorPos_;
+
+      if (is_eof() || (c = GetChar()) != '\\' || is_eof())
+        break;
+
+      // Switch to the unescaped copy at the first escape sequence
+      if (!hasEscapes)
       {
-        c = GetChar();
-        if(!std::char_traits<char>::not_eof(std::char_traits<char>::to_int_type(c)))
-          break;
-        else if(c == 'n')
-          c = '\n';
-        else if(c == 't')
-          c = '\t';
-        else if(c == 'r')
-          c = '\r';
-        else if(c == '"')
-          c = '"';
+        token.stringConst.assign(input_ + first, last - first);
+        hasEscapes = true;
       }
 
-      token.token.push_back(c);
       c = GetChar();
+      if(c == 'n')
+        c = '\n';
+      else if(c == 't')
+        c = '\t';
+      else if(c == 'r')
+        c = '\r';
+      token.stringConst.push_back(c);
     }
 
-    if (c != closingElement)
-      UngetChar();
-
+    token.token = hasEscapes ?
+      StringView(token.stringConst.data(), token.stringConst.size()) :
+      StringView(input_ + first, last - first);
     token.tokenType = TokenType::kConst;
     token.constType = ConstType::kString;
-    token.stringConst = token.token;
 
     return true;
   }
   // Symbol
   else
   {
-    // Push back the symbol
-    token.token.push_back(c);
-
-    #define PAIR(cc,dd) (c==cc&&d==dd) /* Comparison macro for two characters */
     const char d = GetChar();
-    if(PAIR('<', '<') ||
-       PAIR('-', '>') ||
-       (!seperateBraces && PAIR('>', '>')) ||
-       PAIR('!', '=') ||
-       PAIR('<', '=') ||
-       PAIR('>', '=') ||
-       PAIR('+', '+') ||
-       PAIR('-', '-') ||
-       PAIR('+', '=') ||
-       PAIR('-', '=') ||
-       PAIR('*', '=') ||
-       PAIR('/', '=') ||
-       PAIR('^', '=') ||
-       PAIR('|', '=') ||
-       PAIR('&', '=') ||
-       PAIR('~', '=') ||
-       PAIR('%', '=') ||
-       PAIR('&', '&') ||
-       PAIR('|', '|') ||
-       PAIR('=', '=') ||
-       PAIR(':', ':')
-      )
-    #undef PAIR
+    if(IsOperatorPair(c, d) && !(seperateBraces && c == '>' && d == '>'))
     {
-      token.token.push_back(d);
+      token.token = StringView(input_ + token.startPos, 2);
     }
     else
+    {
+      token.token = StringView(input_ + token.startPos, 1);
       UngetChar();
+    }
 
     token.tokenType = TokenType::kSymbol;
 
@@ -421,12 +871,65 @@ bool Tokenizer::GetToken(Token &token, bool angleBracketsForStrings, bool sepera
   return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::ClassifyIdentifier(Token& token)
+{
+  token.atom = atoms_.Intern(token.token.data, token.token.length);
+
+  if(token.atom == kAtomTrue)
+  {
+    token.tokenType = TokenType::kConst;
+    token.constType = ConstType::kBoolean;
+    token.boolConst = true;
+  }
+  else if(token.atom == kAtomFalse)
+  {
+    token.tokenType = TokenType::kConst;
+    token.constType = ConstType::kBoolean;
+    token.boolConst = false;
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 bool Tokenizer::is_eof() const
 {
   return cursorPos_ >= inputLength_;
 }
 
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::BuildLineIndex() const
+{
+  const char* first = input_;
+  const char* last = input_ + inputLength_;
+  newlines_.clear();
+  newlines_.reserve(CountNewlines(first, last));
+  for (first = FindNewline(first, last); first != last; first = FindNewline(first + 1, last))
+    newlines_.push_back(static_cast<std::size_t>(first - input_));
+  lineIndexBuilt_ = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+std::size_t Tokenizer::LineOf(std::size_t position) const
+{
+  if (!lineIndexBuilt_)
+    BuildLineIndex();
+
+  // The line is the number of new lines before the position
+  return startingLine_ + static_cast<std::size_t>(
+    std::lower_bound(newlines_.begin(), newlines_.end(), position) - newlines_.begin());
+}
+
+//--------------------------------------------------------------------------------------------------
+std::size_t Tokenizer::ColumnOf(std::size_t position) const
+{
+  if (!lineIndexBuilt_)
+    BuildLineIndex();
+
+  auto it = std::lower_bound(newlines_.begin(), newlines_.end(), position);
+  std::size_t lineStart = it == newlines_.begin() ? 0 : *(it - 1) + 1;
+  return position - lineStart + 1;
+}
+
 //--------------------------------------------------------------------------------------------------
 bool Tokenizer::GetConst(Token &token)
 {
@@ -456,17 +959,56 @@ bool Tokenizer::GetIdentifier(Token &token)
 //--------------------------------------------------------------------------------------------------
 void Tokenizer::UngetToken(const Token &token)
 {
-  cursorLine_ = token.startLine;
-  cursorPos_ = token.startPos;
+  if (tokenized_)
+  {
+    tokenIndex_ = token.index;
+    return;
+  }
+
+  cursorPos_ = tokenPos_ = token.startPos;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Tokenizer::SkipToClosingBrace(const Token& openingBrace)
+{
+  if (!tokenized_ || openingBrace.index >= tokens_.size() || tokens_[openingBrace.index].partner == kNoPartner)
+    return false;
+
+  tokenIndex_ = tokens_[openingBrace.index].partner;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void Tokenizer::SkipDirective(bool multiLine)
+{
+  // Directives were already skipped when the input was tokenized
+  if (tokenized_)
+    return;
+
+  bool escapedNewline;
+  do
+  {
+    // Skip to the end of the line
+    const char* first = input_ + cursorPos_;
+    const char* last = FindNewline(first, input_ + inputLength_);
+    const char* lastChar = last;
+    if (lastChar != first && lastChar[-1] == '\r')
+      --lastChar;
+    escapedNewline = lastChar != first && lastChar[-1] == '\\';
+
+    Advance(static_cast<std::size_t>(last - input_));
+    if (!is_eof())
+      GetChar();
+  } while (multiLine && escapedNewline && !is_eof());
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Tokenizer::MatchIdentifier(const char *identifier)
+bool Tokenizer::MatchIdentifier(Atom identifier)
 {
   Token token;
   if(GetToken(token))
   {
-    if(token.tokenType == TokenType::kIdentifier && token.token == identifier)
+    if(token.atom == identifier)
       return true;
 
     UngetToken(token);
@@ -491,10 +1033,10 @@ bool Tokenizer::MatchSymbol(const char *symbol)
 }
 
 //--------------------------------------------------------------------------------------------------
-bool Tokenizer::RequireIdentifier(const char *identifier)
+bool Tokenizer::RequireIdentifier(Atom identifier)
 {
   if(!MatchIdentifier(identifier))
-    return Error("Missing identifier %s", identifier);
+    return Error("Missing identifier %s", atoms_.Name(identifier).str().c_str());
   return true;
 }
 
@@ -509,12 +1051,15 @@ bool Tokenizer::RequireSymbol(const char *symbol)
 //-------------------------------------------------------------------------------------------------
 bool Tokenizer::Error(const char* fmt, ...)
 {
-  char buffer[512];
+  // Keep the first error, later ones are usually caused by it
+  if (hasError_)
+    return false;
+
+  const int length = snprintf(error_, sizeof(error_), "%d:%d: ", static_cast<int>(LineOf(tokenPos_)), static_cast<int>(ColumnOf(tokenPos_)));
   va_list args;
   va_start(args, fmt);
-  vsnprintf(buffer, 512, fmt, args);
+  vsnprintf(error_ + length, sizeof(error_) - length, fmt, args);
   va_end(args);
-  printf("ERROR: %d:%d: %s", static_cast<int>(cursorLine_), 0, buffer);
   hasError_ = true;
   return false;
 }
\ No newline at end of file
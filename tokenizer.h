@@ -1,8 +1,10 @@
 #pragma once
 
+#include "atom_table.h"
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 struct Token;
 
@@ -16,8 +18,44 @@ public:
   Tokenizer(const Tokenizer& other) = delete;
   Tokenizer(Tokenizer &&other) = delete;
 
-  /// Reset the parser with the given input text
-  void Reset(const char* input, std::size_t startingLine = 1);
+  /// Reset the parser with the given NUL terminated input text
+  void Reset(const char* input);
+
+  /// Reset the parser with the given input text of the given length. The input does not need to be NUL terminated.
+  void Reset(const char* input, std::size_t length, std::size_t startingLine = 1);
+
+  /**
+   * @brief Lexes the entire input into a flat token array.
+   * @details After this call GetToken and UngetToken operate on the token array instead of the input
+   * text, which makes backtracking a matter of resetting an index. Preprocessor directives are skipped
+   * while tokenizing, so include file names are already lexed as strings.
+   */
+  void Tokenize();
+
+  /// An identifier that was found in the input before tokenizing it, see Tokenize
+  struct Landmark
+  {
+    /// Position of the identifier in the input
+    std::size_t position;
+
+    /// True for annotation macros, false for scope keywords
+    bool annotation;
+
+    /// True if the parser skips the body of the annotated declaration, as it does for functions
+    bool skipBody;
+  };
+
+  /**
+   * @brief Lexes the input into a flat token array, in full only around the given annotations.
+   * @details Every declaration that starts at or after one of the annotation landmarks is lexed in full
+   * up to the ';' that ends it at the same scope depth, except for a body that the parser skips.
+   * Everywhere else only the tokens that matter to skipping declarations and tracking scopes are kept:
+   * braces, semicolons, directives, namespaces and access specifiers. The text in between is not
+   * lexed, a structural scan skips to the next brace, semicolon, string, comment, directive or
+   * landmark and the skipped tokens become a single placeholder token. The landmarks have to include
+   * all scope keywords for that reason, and have to be sorted by position.
+   */
+  void Tokenize(const std::vector<Landmark>& landmarks);
 
   /// Parses a token from the stream
   bool GetToken(Token& token, bool angleBracketsForStrings = false, bool seperateBraces = false);
@@ -31,6 +69,13 @@ public:
   /// Returns a token to the stream, effectively resetting the cursor to the start of the token
   void UngetToken(const Token &token);
 
+  /// Moves the cursor to the closing brace that matches the given opening brace, so that brace is the
+  /// next token. Returns false if the input was not tokenized ahead or the brace is not closed.
+  bool SkipToClosingBrace(const Token& openingBrace);
+
+  /// Returns the last error as "line:column: message", or an empty string if there was none
+  const char* error() const { return error_; }
+
 protected:
   /**
    * @brief Returns the next character from the stream.
@@ -41,6 +86,12 @@ protected:
   /// Resets the cursor to the last read character
   void UngetChar();
 
+  /// Moves the cursor forward to the given position, counting the new lines that are skipped.
+  void Advance(std::size_t position);
+
+  /// Skips a run of white space and control characters.
+  void SkipWhitespaceRun();
+
   /// Returns the next character from the stream but skips comments and white spaces.
   char GetLeadingChar();
 
@@ -50,15 +101,48 @@ protected:
   /// Returns true if the stream is at the end
   bool is_eof() const;
 
+  /// Returns the line of the given position in the input
+  std::size_t LineOf(std::size_t position) const;
+
+  /// Returns the one based column of the given position in the input
+  std::size_t ColumnOf(std::size_t position) const;
+
+  /// Skips the remainder of a preprocessor directive, including escaped new lines if multiLine is set.
+  void SkipDirective(bool multiLine);
+
+private:
+  /// Lexes the next token from the input text. Identifiers are only interned if classifyIdentifiers is set.
+  bool LexToken(Token& token, bool angleBracketsForStrings, bool seperateBraces, bool classifyIdentifiers = true);
+
+  /// Interns the text of an identifier token and turns true and false into boolean constants
+  void ClassifyIdentifier(Token& token);
+
+  /// Lexes the input into the token array, see Tokenize. Everything is lexed in full if landmarks is null.
+  void TokenizeInput(const std::vector<Landmark>* landmarks);
+
+  /// Moves the cursor over the text that can be skipped before the given position, see Tokenize.
+  /// Returns true if a placeholder was added or extended.
+  bool SkipColdText(std::size_t limit, bool extend);
+
+  /// Appends a lexed token to the token array
+  void PushToken(const Token& token);
+
+  /// Appends a placeholder for the token to the token array, or extends the last placeholder up to the
+  /// end of the token
+  void PushPlaceholder(const Token& token, bool extend);
+
+  /// Stores the comment preceding the current token. Returns its index or kNoComment.
+  uint32_t PushComment();
+
 protected:
-  /// Returns true if the current token is an identifier with the given text
-  bool MatchIdentifier(const char* identifier);
+  /// Returns true if the current token is the given identifier
+  bool MatchIdentifier(Atom identifier);
 
   /// Returns true if the current token is a symbol with the given text
   bool MatchSymbol(const char* symbol);
 
   /// Advances the tokenizer past the expected identifier or errors if the symbol is not encountered.
-  bool RequireIdentifier(const char* identifier);
+  bool RequireIdentifier(Atom identifier);
 
   /// Advances the tokenizer past the expected symbol or errors if the symbol is not encountered.
   bool RequireSymbol(const char* symbol);
@@ -77,24 +161,88 @@ protected:
   /// Current position in the input
   std::size_t cursorPos_;
 
-  /// Current line of the cursor
-  std::size_t cursorLine_;
-
   /// The cursor position of the last read character
   std::size_t prevCursorPos_;
 
-  /// The cursor line of the the last read character
-  std::size_t prevCursorLine_;
+  /// Start position of the last token returned by GetToken
+  std::size_t tokenPos_;
 
-  /// Stores the last comment block
+  /// Stores the location of the last comment block. Consecutive single line comments form one block.
   struct Comment {
-    std::string text;
-    std::size_t startLine;
-    std::size_t endLine;
+    Comment() : startPos(0), endPos(0), nextPos(0) {}
+
+    bool empty() const { return endPos == startPos; }
+
+    /// The range of the comment in the input, including the comment markers
+    std::size_t startPos;
+    std::size_t endPos;
+
+    /// The position of the first token after the comment
+    std::size_t nextPos;
   };
 
+  /// Stores the text of the given comment in text, with comment markers and indentation removed
+  void CommentText(const Comment& comment, std::string& text) const;
+
   Comment comment_;
   Comment lastComment_;
 
+  /// The atoms of all identifiers encountered
+  AtomTable atoms_;
+
   bool hasError_ = false;
+
+  /// The message of the last error, see error
+  char error_[512];
+
+private:
+  /// Compact representation of a token in the token array
+  struct LexedToken
+  {
+    uint32_t startPos;
+
+    /// Position of the text in the input, or in escapedText_ for escaped string constants
+    uint32_t textPos;
+    uint32_t textLength;
+
+    /// Index of the comment directly preceding the token, or kNoComment
+    uint32_t comment;
+
+    uint8_t tokenType;
+    uint8_t constType;
+    bool isEscaped;
+
+    /// Index of the matching brace of a brace token, or kNoPartner
+    uint32_t partner;
+
+    /// The value of constants or the atom of identifiers
+    uint64_t value;
+  };
+
+  static const uint32_t kNoComment = UINT32_MAX;
+  static const uint32_t kNoPartner = UINT32_MAX;
+
+  /// True if the input was tokenized ahead
+  bool tokenized_ = false;
+
+  /// The token array and the index of the next token to return from it
+  std::vector<LexedToken> tokens_;
+  std::size_t tokenIndex_ = 0;
+
+  /// Indices of the opening braces in the token array that are not closed yet
+  std::vector<uint32_t> openBraces_;
+
+  /// The comments referred to by the token array
+  std::vector<Comment> comments_;
+
+  /// Unescaped text of all string constants with escape sequences
+  std::string escapedText_;
+
+  /// The line of the start of the input
+  std::size_t startingLine_ = 1;
+
+  /// Positions of all new lines in the input, built the first time a line is requested
+  void BuildLineIndex() const;
+  mutable std::vector<std::size_t> newlines_;
+  mutable bool lineIndexBuilt_ = false;
 };
\ No newline at end of file
@@ -1,11 +1,21 @@
 #pragma once
 
+#include "token.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
 #include <vector>
-#include <memory>
+
+/// A range of entries in the text or argument array of a TypeTree
+struct TypeRange
+{
+  uint32_t first;
+  uint32_t count;
+};
 
 struct TypeNode
 {
-  enum class Type
+  enum class Type : uint8_t
   {
     kPointer,
     kReference,
@@ -15,112 +25,214 @@ struct TypeNode
     kFunction
   };
 
-  TypeNode(Type t) :
-    type(t) {}
+  /// Payload of literals and templates
+  struct Named
+  {
+    /// The name in the text of the tree
+    TypeRange name;
 
-  bool isConst = false;
-  bool isVolatile = false;
-  bool isMutable = false;
+    /// The template arguments, empty for literals
+    TypeRange arguments;
+  };
 
-  Type type;
-};
+  /// Payload of functions
+  struct Function
+  {
+    /// Index of the return type
+    uint32_t returns;
 
-struct PointerNode : public TypeNode
-{
-  PointerNode(std::unique_ptr<TypeNode> && b) :
-    TypeNode(TypeNode::Type::kPointer),
-    base(std::forward<std::unique_ptr<TypeNode>>(b)){}
+    TypeRange arguments;
+  };
 
-  std::unique_ptr<TypeNode> base;
-};
+  Type type;
+  bool isConst;
+  bool isVolatile;
+  bool isMutable;
 
-struct ReferenceNode : public TypeNode
-{
-  ReferenceNode(std::unique_ptr<TypeNode> && b) :
-    TypeNode(TypeNode::Type::kReference),
-    base(std::forward<std::unique_ptr<TypeNode>>(b)){}
+  union
+  {
+    /// Index of the type a pointer or reference refers to
+    uint32_t base;
 
-  std::unique_ptr<TypeNode> base;
+    Named named;
+    Function function;
+  };
 };
 
-struct LReferenceNode : public TypeNode
+/// An argument of a template or function
+struct TypeArgument
 {
-  LReferenceNode(std::unique_ptr<TypeNode> && b) :
-    TypeNode(TypeNode::Type::kLReference),
-    base(std::forward<std::unique_ptr<TypeNode>>(b)){}
+  /// The name of a function argument, empty if the argument is unnamed and for template arguments
+  TypeRange name;
 
-  std::unique_ptr<TypeNode> base;
+  /// Index of the type of the argument
+  uint32_t type;
 };
 
-struct TemplateNode : public TypeNode
+/// Index returned instead of a node if a type could not be parsed
+static const uint32_t kNoTypeNode = UINT32_MAX;
+
+// Clearing a tree does not have to destroy its nodes one by one
+static_assert(std::is_trivially_destructible<TypeNode>::value, "TypeNode must be trivially destructible");
+static_assert(std::is_trivially_destructible<TypeArgument>::value, "TypeArgument must be trivially destructible");
+
+/**
+ * @brief Stores the nodes of a type in a few flat arrays.
+ * @details Nodes refer to each other by index into the node array. The arguments of a node occupy a
+ * contiguous range of the argument array and all names are stored in a single text buffer. The arrays
+ * act as the arena of the parser for types: nodes, arguments and names are appended to them, and
+ * Clear releases all of them at once in constant time while keeping the capacity of the arrays. A tree
+ * that is reused for every type therefore stops allocating memory after a while, and Shrink bounds the
+ * memory it keeps once an unusually large type was parsed.
+ */
+class TypeTree
 {
-  TemplateNode(const std::string& n) :
-    TypeNode(TypeNode::Type::kTemplate),
-    name(n) {}
+public:
+  /// Removes all nodes
+  void Clear()
+  {
+    nodes_.clear();
+    arguments_.clear();
+    pendingArguments_.clear();
+    text_.clear();
+  }
 
-  std::string name;
-  std::vector<std::unique_ptr<TypeNode>> arguments;
-};
+  /// Removes all nodes and frees the arrays if together they keep more than the given number of bytes
+  void Shrink(std::size_t maxBytes)
+  {
+    Clear();
+    const std::size_t bytes = nodes_.capacity() * sizeof(TypeNode) + text_.capacity() +
+      (arguments_.capacity() + pendingArguments_.capacity()) * sizeof(TypeArgument);
+    if (bytes <= maxBytes)
+      return;
+
+    std::vector<TypeNode>().swap(nodes_);
+    std::vector<TypeArgument>().swap(arguments_);
+    std::vector<TypeArgument>().swap(pendingArguments_);
+    std::string().swap(text_);
+  }
 
-struct LiteralNode : public TypeNode
-{
-  LiteralNode(const std::string& ref) :
-    TypeNode(TypeNode::Type::kLiteral),
-    name(ref) {}
+  const TypeNode& node(uint32_t index) const { return nodes_[index]; }
+  TypeNode& node(uint32_t index) { return nodes_[index]; }
+  const TypeArgument& argument(uint32_t index) const { return arguments_[index]; }
 
-  std::string name;
-};
+  /// Returns the text of the given range. The text is only valid until the next call to AddText.
+  StringView text(const TypeRange& range) const { return StringView(text_.data() + range.first, range.count); }
 
-struct FunctionNode : public TypeNode
-{
-  FunctionNode() : TypeNode(TypeNode::Type::kFunction) {}
+  /// Adds a node of the given type without any qualifiers and returns its index
+  uint32_t AddNode(TypeNode::Type type)
+  {
+    TypeNode node = TypeNode();
+    node.type = type;
+    nodes_.push_back(node);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
 
-  struct Argument
+  /// Appends text to the text of the tree and returns its range
+  TypeRange AddText(const char* text, std::size_t length)
   {
-    std::string name;
-    std::unique_ptr<TypeNode> type;
-  };
+    TypeRange range = { static_cast<uint32_t>(text_.size()), static_cast<uint32_t>(length) };
+    text_.append(text, length);
+    return range;
+  }
 
+  /// Appends text to the last range returned by AddText
+  void AppendText(TypeRange& range, const char* text, std::size_t length)
+  {
+    text_.append(text, length);
+    range.count += static_cast<uint32_t>(length);
+  }
 
-  std::unique_ptr<TypeNode> returns;
-  std::vector<std::unique_ptr<Argument>> arguments;
-};
+  /**
+   * @brief Collects the arguments of a node that is being parsed.
+   * @details Arguments can contain nodes with arguments of their own, so arguments are collected on a
+   * stack first. PendingArguments marks the start of the arguments of a node, PopArguments moves them
+   * to a contiguous range of the argument array once the node is complete.
+   */
+  std::size_t PendingArguments() const { return pendingArguments_.size(); }
+  void PushArgument(const TypeRange& name, uint32_t type)
+  {
+    TypeArgument argument = { name, type };
+    pendingArguments_.push_back(argument);
+  }
+  TypeRange PopArguments(std::size_t mark)
+  {
+    TypeRange range = { static_cast<uint32_t>(arguments_.size()), static_cast<uint32_t>(pendingArguments_.size() - mark) };
+    arguments_.insert(arguments_.end(), pendingArguments_.begin() + static_cast<std::ptrdiff_t>(mark), pendingArguments_.end());
+    pendingArguments_.resize(mark);
+    return range;
+  }
 
-struct ITypeNodeVisitor
-{
-  virtual void VisitNode(TypeNode &node) = 0;
-  virtual void Visit(PointerNode& node) = 0;
-  virtual void Visit(ReferenceNode& node) = 0;
-  virtual void Visit(LReferenceNode& node) = 0;
-  virtual void Visit(LiteralNode& node) = 0;
-  virtual void Visit(TemplateNode& node) = 0;
-  virtual void Visit(FunctionNode& node) = 0;
+private:
+  std::vector<TypeNode> nodes_;
+  std::vector<TypeArgument> arguments_;
+  std::vector<TypeArgument> pendingArguments_;
+  std::string text_;
 };
 
-struct TypeNodeVisitor : public ITypeNodeVisitor
+/**
+ * @brief Walks the nodes of a TypeTree without virtual calls.
+ * @details Derived classes pass themselves as the template argument and hide the Visit functions they
+ * are interested in; all calls are resolved at compile time. The default implementations visit the
+ * children of a node.
+ */
+template<typename Derived>
+class TypeNodeVisitor
 {
-  void VisitNode(TypeNode &node) override
+public:
+  explicit TypeNodeVisitor(const TypeTree& tree) :
+    tree_(tree) {}
+
+  /// Visits the node at the given index
+  void VisitNode(uint32_t index)
   {
+    const TypeNode& node = tree_.node(index);
     switch (node.type)
     {
     case TypeNode::Type::kPointer:
-      Visit(reinterpret_cast<PointerNode&>(node));
+      derived().VisitPointer(node);
       break;
     case TypeNode::Type::kReference:
-      Visit(reinterpret_cast<ReferenceNode&>(node));
+      derived().VisitReference(node);
       break;
     case TypeNode::Type::kLReference:
-      Visit(reinterpret_cast<LReferenceNode&>(node));
+      derived().VisitLReference(node);
       break;
     case TypeNode::Type::kLiteral:
-      Visit(reinterpret_cast<LiteralNode&>(node));
+      derived().VisitLiteral(node);
       break;
     case TypeNode::Type::kTemplate:
-      Visit(reinterpret_cast<TemplateNode&>(node));
+      derived().VisitTemplate(node);
       break;
     case TypeNode::Type::kFunction:
-      Visit(reinterpret_cast<FunctionNode&>(node));
+      derived().VisitFunction(node);
       break;
     }
   }
+
+  void VisitPointer(const TypeNode& node) { derived().VisitNode(node.base); }
+  void VisitReference(const TypeNode& node) { derived().VisitNode(node.base); }
+  void VisitLReference(const TypeNode& node) { derived().VisitNode(node.base); }
+  void VisitLiteral(const TypeNode&) {}
+
+  void VisitTemplate(const TypeNode& node)
+  {
+    for (uint32_t i = 0; i < node.named.arguments.count; ++i)
+      derived().VisitNode(tree_.argument(node.named.arguments.first + i).type);
+  }
+
+  void VisitFunction(const TypeNode& node)
+  {
+    derived().VisitNode(node.function.returns);
+    for (uint32_t i = 0; i < node.function.arguments.count; ++i)
+      derived().VisitNode(tree_.argument(node.function.arguments.first + i).type);
+  }
+
+protected:
+  const TypeTree& tree() const { return tree_; }
+
+private:
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  const TypeTree& tree_;
 };
@@ -0,0 +1,174 @@
+#include "type_table.h"
+#include <cstring>
+
+namespace {
+  //------------------------------------------------------------------------------------------------
+  inline uint32_t Hash(const std::string& key)
+  {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < key.size(); ++i)
+      hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+    return hash;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void TypeTable::Clear()
+{
+  types_.Clear();
+  keys_.clear();
+  keyText_.clear();
+  slots_.assign(slots_.size(), kNoTypeNode);
+  argumentIds_.clear();
+  size_ = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+void TypeTable::Grow()
+{
+  slots_.assign(slots_.size() * 2, kNoTypeNode);
+  const std::size_t mask = slots_.size() - 1;
+  for (uint32_t id = 0; id < keys_.size(); ++id)
+  {
+    std::size_t slot = keys_[id].hash & mask;
+    while (slots_[slot] != kNoTypeNode)
+      slot = (slot + 1) & mask;
+    slots_[slot] = id;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t TypeTable::Intern(const TypeTree& tree, uint32_t index)
+{
+  const TypeNode& node = tree.node(index);
+
+  // Intern the children first, their ids are part of the key of this node
+  uint32_t base = 0;
+  TypeRange arguments = TypeRange();
+  switch (node.type)
+  {
+  case TypeNode::Type::kPointer:
+  case TypeNode::Type::kReference:
+  case TypeNode::Type::kLReference:
+    base = Intern(tree, node.base);
+    break;
+  case TypeNode::Type::kLiteral:
+    break;
+  case TypeNode::Type::kTemplate:
+    arguments = node.named.arguments;
+    break;
+  case TypeNode::Type::kFunction:
+    base = Intern(tree, node.function.returns);
+    arguments = node.function.arguments;
+    break;
+  }
+
+  const std::size_t mark = argumentIds_.size();
+  for (uint32_t i = 0; i < arguments.count; ++i)
+  {
+    uint32_t argument = Intern(tree, tree.argument(arguments.first + i).type);
+    argumentIds_.push_back(argument);
+  }
+
+  // Build the key: kind, qualifiers, child ids, then the names that are part of the node
+  key_.clear();
+  const uint8_t header[4] = {
+    static_cast<uint8_t>(node.type),
+    static_cast<uint8_t>(node.isConst),
+    static_cast<uint8_t>(node.isVolatile),
+    static_cast<uint8_t>(node.isMutable)
+  };
+  AppendKey(header, sizeof(header));
+  AppendKey(&base, sizeof(base));
+  AppendKey(&arguments.count, sizeof(arguments.count));
+  if (arguments.count != 0)
+    AppendKey(argumentIds_.data() + mark, arguments.count * sizeof(uint32_t));
+  if (node.type == TypeNode::Type::kLiteral || node.type == TypeNode::Type::kTemplate)
+  {
+    StringView name = tree.text(node.named.name);
+    AppendKey(name.data, name.length);
+  }
+  else if (node.type == TypeNode::Type::kFunction)
+  {
+    // Argument names are separated by their lengths
+    for (uint32_t i = 0; i < arguments.count; ++i)
+    {
+      StringView name = tree.text(tree.argument(arguments.first + i).name);
+      uint32_t length = static_cast<uint32_t>(name.length);
+      AppendKey(&length, sizeof(length));
+      AppendKey(name.data, name.length);
+    }
+  }
+
+  if (slots_.empty())
+    slots_.assign(256, kNoTypeNode);
+
+  const uint32_t hash = Hash(key_);
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t slot = hash & mask;
+  for (; slots_[slot] != kNoTypeNode; slot = (slot + 1) & mask)
+  {
+    const Key& key = keys_[slots_[slot]];
+    if (key.hash == hash && key.length == key_.size() &&
+        std::memcmp(keyText_.data() + key.first, key_.data(), key_.size()) == 0)
+    {
+      argumentIds_.resize(mark);
+      return slots_[slot];
+    }
+  }
+
+  // Copy the node into the table
+  const uint32_t id = types_.AddNode(node.type);
+  TypeNode& copy = types_.node(id);
+  copy.isConst = node.isConst;
+  copy.isVolatile = node.isVolatile;
+  copy.isMutable = node.isMutable;
+
+  const std::size_t argumentMark = types_.PendingArguments();
+  for (uint32_t i = 0; i < arguments.count; ++i)
+  {
+    TypeRange name = TypeRange();
+    if (node.type == TypeNode::Type::kFunction)
+    {
+      StringView text = tree.text(tree.argument(arguments.first + i).name);
+      if (!text.empty())
+        name = types_.AddText(text.data, text.length);
+    }
+    types_.PushArgument(name, argumentIds_[mark + i]);
+  }
+  argumentIds_.resize(mark);
+
+  switch (node.type)
+  {
+  case TypeNode::Type::kPointer:
+  case TypeNode::Type::kReference:
+  case TypeNode::Type::kLReference:
+    types_.node(id).base = base;
+    break;
+  case TypeNode::Type::kLiteral:
+  case TypeNode::Type::kTemplate:
+    {
+      StringView name = tree.text(node.named.name);
+      TypeRange range = types_.AddText(name.data, name.length);
+      types_.node(id).named.name = range;
+      types_.node(id).named.arguments = types_.PopArguments(argumentMark);
+    }
+    break;
+  case TypeNode::Type::kFunction:
+    types_.node(id).function.returns = base;
+    types_.node(id).function.arguments = types_.PopArguments(argumentMark);
+    break;
+  }
+
+  Key key = { static_cast<uint32_t>(keyText_.size()), static_cast<uint32_t>(key_.size()), hash };
+  keys_.push_back(key);
+  keyText_.append(key_);
+  slots_[slot] = id;
+  ++size_;
+
+  // Keep the load factor below one half
+  if (keys_.size() * 2 > slots_.size())
+    Grow();
+  return id;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "type_node.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stores every distinct type node once.
+ * @details Types are hash-consed node by node: a node is identified by its kind, qualifiers, name and
+ * the ids of its children, so equal types share a single id and equal subtypes are shared between
+ * different types. The nodes of the table are stored in a TypeTree in which the index of a node is its
+ * id and children refer to the ids of other nodes of the table.
+ */
+class TypeTable
+{
+public:
+  /// Returns the id of the type rooted at the given node of the tree, adding it if it is new
+  uint32_t Intern(const TypeTree& tree, uint32_t node);
+
+  /// Removes all types. Allocated memory is kept for the next file.
+  void Clear();
+
+  /// Returns the number of distinct type nodes
+  std::size_t size() const { return size_; }
+
+  /// Returns the nodes of the table, indexed by id
+  const TypeTree& types() const { return types_; }
+
+private:
+  /// Appends the bytes of a value to the key
+  void AppendKey(const void* data, std::size_t length) { key_.append(static_cast<const char*>(data), length); }
+
+  /// Doubles the number of hash slots
+  void Grow();
+
+private:
+  TypeTree types_;
+  std::size_t size_ = 0;
+
+  /// The key of every node, indexed by id. The keys are stored one after the other in keyText_.
+  struct Key
+  {
+    uint32_t first;
+    uint32_t length;
+    uint32_t hash;
+  };
+  std::vector<Key> keys_;
+  std::string keyText_;
+
+  /// Open addressing hash table of ids, kNoTypeNode marks an empty slot
+  std::vector<uint32_t> slots_;
+
+  /// The key of the node that is being interned
+  std::string key_;
+
+  /// Ids of the arguments of the nodes that are being interned
+  std::vector<uint32_t> argumentIds_;
+};